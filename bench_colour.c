@@ -0,0 +1,235 @@
+//  MIT license
+// Microbenchmarks of the colour math in srgb.c, no GL involved.
+// Each benchmark runs its loop until it took at least min_time, then
+// reports time and cycles per element, like google benchmark does (and
+// with --json=<file> in its JSON layout, so its compare tools work).
+// usage: bench_colour [--filter=<substring>] [--min_time=<s>] [--json=<file>]
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#else
+#define HAVE_RDTSC 0
+#endif
+#include "srgb.h"
+
+#define MAX_RESULTS 64
+
+struct result {
+    char name[64];
+    long elements;
+    long iterations;
+    double ns_per_element;
+    // -1 without a cycle counter
+    double cycles_per_element;
+};
+
+static struct result results[MAX_RESULTS];
+static int results_count;
+// written so the compiler cannot drop the work
+static volatile float sink_f;
+static volatile uint8_t sink_u8;
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static unsigned long long cycles(void) {
+#if HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// inputs of the transfer functions
+enum distribution {
+    UNIFORM,
+    NEAR_ZERO,
+    NEAR_ONE,
+    DENORMAL,
+    NOT_A_NUMBER,
+    DISTRIBUTIONS_COUNT
+};
+
+static const char *const distribution_names[] = {"uniform", "near_zero", "near_one", "denormal", "nan"};
+
+static void fill(float *values, long n, enum distribution distribution) {
+    srand(1);
+    for (long i = 0; i < n; ++i) {
+        float r = rand() / (float)RAND_MAX;
+        switch (distribution) {
+            case UNIFORM: values[i] = r; break;
+            // the linear segment of both functions and a bit past it
+            case NEAR_ZERO: values[i] = r * 0.01f; break;
+            case NEAR_ONE: values[i] = 1.0f - r * 0.01f; break;
+            case DENORMAL: values[i] = r * FLT_MIN; break;
+            case NOT_A_NUMBER: values[i] = NAN; break;
+            default: break;
+        }
+    }
+}
+
+typedef void (*bench_fn)(void *arg, long n);
+
+struct array_arg {
+    float *in;
+    float *out;
+};
+
+static void bench_linear_to_srgb(void *arg, long n) {
+    struct array_arg *a = arg;
+    for (long i = 0; i < n; ++i) {
+        a->out[i] = linear_to_srgb(a->in[i]);
+    }
+    sink_f = a->out[n - 1];
+}
+
+static void bench_srgb_to_linear(void *arg, long n) {
+    struct array_arg *a = arg;
+    for (long i = 0; i < n; ++i) {
+        a->out[i] = srgb_to_linear(a->in[i]);
+    }
+    sink_f = a->out[n - 1];
+}
+
+static void bench_srgb_ramp(void *arg, long n) {
+    uint8_t *pixels = arg;
+    srgb_ramp(pixels, n);
+    sink_u8 = pixels[n - 1];
+}
+
+struct grey_pma_arg {
+    uint8_t *pixels;
+    int width;
+};
+
+static void bench_grey_pma_pixels(void *arg, long n) {
+    struct grey_pma_arg *a = arg;
+    srgb_grey_pma_pixels(a->pixels, a->width, n / a->width, 1, 255);
+    sink_u8 = a->pixels[0];
+}
+
+// runs fn over n elements until min_time seconds, doubling the
+// iterations from one, and records the per element cost
+static void run(const char *name, const char *filter, double min_time, bench_fn fn, void *arg, long n) {
+    if (filter && !strstr(name, filter)) return;
+    if (results_count == MAX_RESULTS) {
+        fprintf(stderr, "too many benchmarks, %s not run\n", name);
+        return;
+    }
+    // warm up caches and branch predictors
+    fn(arg, n);
+    long iterations = 1;
+    double ns;
+    unsigned long long c;
+    for (;;) {
+        double start = now_ns();
+        unsigned long long start_cycles = cycles();
+        for (long i = 0; i < iterations; ++i) {
+            fn(arg, n);
+        }
+        c = cycles() - start_cycles;
+        ns = now_ns() - start;
+        if (ns >= min_time * 1e9 || iterations >= (1L << 30)) break;
+        iterations *= 2;
+    }
+    struct result *r = &results[results_count++];
+    snprintf(r->name, sizeof r->name, "%s", name);
+    r->elements = n;
+    r->iterations = iterations;
+    double elements = (double)iterations * n;
+    r->ns_per_element = ns / elements;
+    r->cycles_per_element = HAVE_RDTSC ? c / elements : -1;
+    printf("%-36s %12ld %10.3f ns/elem %10.2f cycles/elem\n", r->name, r->iterations, r->ns_per_element, r->cycles_per_element);
+}
+
+static int write_json(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    time_t t = time(0);
+    char date[32];
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", localtime(&t));
+    fprintf(f, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": \"bench_colour\",\n    \"cycle_counter\": %s\n  },\n",
+        date, HAVE_RDTSC ? "\"rdtsc\"" : "null");
+    fprintf(f, "  \"benchmarks\": [\n");
+    for (int i = 0; i < results_count; ++i) {
+        struct result *r = &results[i];
+        // real_time/cpu_time per iteration, as google benchmark reports them
+        double per_iteration = r->ns_per_element * r->elements;
+        fprintf(f, "    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %ld, \"real_time\": %.3f, \"cpu_time\": %.3f, "
+            "\"time_unit\": \"ns\", \"elements\": %ld, \"ns_per_element\": %.4f, \"cycles_per_element\": %.3f}%s\n",
+            r->name, r->iterations, per_iteration, per_iteration, r->elements, r->ns_per_element, r->cycles_per_element,
+            i + 1 < results_count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *filter = 0;
+    const char *json = 0;
+    double min_time = 0.1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strncmp(argv[i], "--filter=", strlen("--filter="))) {
+            filter = argv[i] + strlen("--filter=");
+        } else if (!strncmp(argv[i], "--min_time=", strlen("--min_time="))) {
+            min_time = atof(argv[i] + strlen("--min_time="));
+        } else if (!strncmp(argv[i], "--json=", strlen("--json="))) {
+            json = argv[i] + strlen("--json=");
+        } else {
+            fprintf(stderr, "usage: bench_colour [--filter=<substring>] [--min_time=<s>] [--json=<file>]\n");
+            return 1;
+        }
+    }
+    // in cache, out of L1, out of L2
+    static const long sizes[] = {256, 16384, 1L << 20};
+    long max_size = sizes[sizeof sizes / sizeof sizes[0] - 1];
+    float *in = malloc(max_size * sizeof (float));
+    float *out = malloc(max_size * sizeof (float));
+    uint8_t *pixels = malloc(1024 * 1024 * 4);
+    if (!in || !out || !pixels) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    char name[64];
+    struct array_arg arrays = {in, out};
+    for (int d = 0; d < DISTRIBUTIONS_COUNT; ++d) {
+        for (size_t s = 0; s < sizeof sizes / sizeof sizes[0]; ++s) {
+            fill(in, sizes[s], d);
+            snprintf(name, sizeof name, "linear_to_srgb/%s/%ld", distribution_names[d], sizes[s]);
+            run(name, filter, min_time, bench_linear_to_srgb, &arrays, sizes[s]);
+            snprintf(name, sizeof name, "srgb_to_linear/%s/%ld", distribution_names[d], sizes[s]);
+            run(name, filter, min_time, bench_srgb_to_linear, &arrays, sizes[s]);
+        }
+    }
+    // the size create_a_texture_srgb_ramp uses, and larger
+    static const long ramp_sizes[] = {4096, 65536};
+    for (size_t s = 0; s < sizeof ramp_sizes / sizeof ramp_sizes[0]; ++s) {
+        snprintf(name, sizeof name, "srgb_ramp/%ld", ramp_sizes[s]);
+        run(name, filter, min_time, bench_srgb_ramp, pixels, ramp_sizes[s]);
+    }
+    // the darkgrey texture, a pattern_atlas page, a large texture
+    static const int grey_pma_sizes[] = {4, 256, 1024};
+    for (size_t s = 0; s < sizeof grey_pma_sizes / sizeof grey_pma_sizes[0]; ++s) {
+        struct grey_pma_arg arg = {pixels, grey_pma_sizes[s]};
+        snprintf(name, sizeof name, "srgb_grey_pma_pixels/%dx%d", grey_pma_sizes[s], grey_pma_sizes[s]);
+        run(name, filter, min_time, bench_grey_pma_pixels, &arg, (long)grey_pma_sizes[s] * grey_pma_sizes[s]);
+    }
+    free(in);
+    free(out);
+    free(pixels);
+    if (json && write_json(json)) return 1;
+    return 0;
+}
@@ -0,0 +1,362 @@
+//  MIT license
+// End to end frame benchmark of the dark-grey quad scene, headless (an
+// EGL pbuffer, so it runs in CI on Mesa llvmpipe without a GPU or X):
+// direct to an sRGB default framebuffer, and through an fbo with the
+// ramp post-process (the workaround in the README) to a linear one, as
+// on the drivers that need it, at 600x600, 1080p and 4K. Per frame: CPU
+// time to submit, GPU time (timer query) and frames/s of an
+// unsynchronized run. The center pixel must be (1,1,1,255), else the
+// case fails. On GL llvmpipe encodes the linear pbuffer too while
+// GL_FRAMEBUFFER_SRGB is on, so it is off while presenting to it.
+// --json=<file> writes the results in the layout of bench_colour,
+// bench_frame_llvmpipe.json is the baseline.
+// --dump=<dir> adds a run per case that reads every frame back and hands
+// it to a frame_sink (--dump_format=ppm|png|exr, png by default): frames
+// the encoder cannot keep up with are dropped, not waited for.
+// --log=<file> reads the frames of that run into a frame_log instead (or
+// as well), of --log_records=<n> records (default 16). Each record fits
+// the largest size benched, a 4K frame (33.2 MB), whatever the size of
+// the frame in it: 16 records preallocate about 530 MB.
+// usage: bench_frame [--api=gl|gles2] [--frames=<n>] [--json=<file>]
+//     [--dump=<dir> [--dump_format=<format>]] [--log=<file> [--log_records=<n>]]
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "glad/glad.h"
+#include "gl_error.h"
+#include "gl_load.h"
+#include "gl_state.h"
+#include "gl_timer.h"
+#include "frame_log.h"
+#include "frame_sink.h"
+#include "scene.h"
+
+#define MAX_RESULTS 16
+// frames queued at most, each the size of a 4K rgba8 frame
+#define DUMP_SLOTS 4
+
+struct egl_handles {
+    EGLDisplay dpy;
+    // linear, and sRGB encoded if srgb (EGL_KHR_gl_colorspace)
+    EGLSurface surfaces[2];
+    EGLContext ctx;
+    int srgb;
+};
+
+struct result {
+    char name[64];
+    int frames;
+    double submit_ms;
+    // -1 without timer queries
+    double gpu_ms;
+    double fps;
+    uint8_t center[4];
+};
+
+static struct result results[MAX_RESULTS];
+static int results_count;
+
+static EGLDisplay get_display(void) {
+    // surfaceless: no X or wayland needed, else whatever the default is
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+// pbuffers of width x height with a context for api, the sRGB one current
+static int setup_egl(enum gl_api api, int width, int height, struct egl_handles *out) {
+    out->dpy = get_display();
+    EGLint major, minor;
+    if (out->dpy == EGL_NO_DISPLAY || !eglInitialize(out->dpy, &major, &minor)) {
+        fprintf(stderr, "eglInitialize failed\n");
+        return 1;
+    }
+    int is_gl = api == GL_API_OPENGL;
+    EGLint const config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_RENDERABLE_TYPE, is_gl ? EGL_OPENGL_BIT : EGL_OPENGL_ES2_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint count;
+    if (!eglChooseConfig(out->dpy, config_attribs, &config, 1, &count) || !count) {
+        fprintf(stderr, "eglChooseConfig: no rgba8 pbuffer config\n");
+        return 1;
+    }
+    const char *extensions = eglQueryString(out->dpy, EGL_EXTENSIONS);
+    out->srgb = extensions && strstr(extensions, "EGL_KHR_gl_colorspace");
+    for (int srgb = 0; srgb < 2; ++srgb) {
+        EGLint const surface_attribs[] = {
+            EGL_WIDTH, width, EGL_HEIGHT, height,
+            out->srgb ? EGL_GL_COLORSPACE_KHR : EGL_NONE,
+            srgb ? EGL_GL_COLORSPACE_SRGB_KHR : EGL_GL_COLORSPACE_LINEAR_KHR, EGL_NONE};
+        out->surfaces[srgb] = eglCreatePbufferSurface(out->dpy, config, surface_attribs);
+        if (out->surfaces[srgb] == EGL_NO_SURFACE) {
+            fprintf(stderr, "eglCreatePbufferSurface %dx%d failed: 0x%x\n", width, height, eglGetError());
+            return 1;
+        }
+    }
+    eglBindAPI(is_gl ? EGL_OPENGL_API : EGL_OPENGL_ES_API);
+    // a 3.3 core request gets the highest core version there is (and
+    // GL ES 2 the highest GL ES), as glsrgb's GLX 4.6 / ES 2 contexts
+    EGLint const gl_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+    EGLint const gles2_attribs[] = {EGL_CONTEXT_MAJOR_VERSION, 2, EGL_NONE};
+    out->ctx = eglCreateContext(out->dpy, config, EGL_NO_CONTEXT, is_gl ? gl_attribs : gles2_attribs);
+    if (out->ctx == EGL_NO_CONTEXT) {
+        fprintf(stderr, "eglCreateContext failed: 0x%x\n", eglGetError());
+        return 1;
+    }
+    if (!eglMakeCurrent(out->dpy, out->surfaces[1], out->surfaces[1], out->ctx)) {
+        fprintf(stderr, "eglMakeCurrent failed\n");
+        return 1;
+    }
+    if (gl_load_procs(api, (GLADloadproc)eglGetProcAddress)) {
+        fprintf(stderr, "gl_load_procs failed\n");
+        return 1;
+    }
+    gl_state_reset();
+    if (is_gl) gl_state_enable(GL_FRAMEBUFFER_SRGB, 1);
+    if (CHECK_GL()) return 1;
+    return 0;
+}
+
+static void teardown_egl(struct egl_handles *egl) {
+    eglMakeCurrent(egl->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(egl->dpy, egl->ctx);
+    eglDestroySurface(egl->dpy, egl->surfaces[0]);
+    eglDestroySurface(egl->dpy, egl->surfaces[1]);
+    eglTerminate(egl->dpy);
+}
+
+// frames of one mode and size into the srgb or linear pbuffer: first
+// each synchronized on its timer query (submit and GPU time), then all
+// in a row and one glFinish (fps), then with sink or log each read back
+// and queued for writing, or appended to the log
+static int bench(struct egl_handles *egl, struct scene *scene, struct gl_timer *timer, enum gl_api api, const char *mode, int use_fbo,
+        int srgb, int width, int height, int frames, struct frame_sink *sink, struct frame_log *log) {
+    if (results_count == MAX_RESULTS) return 1;
+    // the same context, only the default framebuffer changes
+    if (!eglMakeCurrent(egl->dpy, egl->surfaces[srgb], egl->surfaces[srgb], egl->ctx)) {
+        fprintf(stderr, "eglMakeCurrent failed\n");
+        return 1;
+    }
+    scene->linear_window = api == GL_API_OPENGL && !srgb;
+    struct result *r = &results[results_count];
+    snprintf(r->name, sizeof r->name, "frame/%s/%dx%d", mode, width, height);
+    r->frames = frames;
+    // warm up: targets made, shaders compiled, caches filled
+    for (int f = 0; f < 3; ++f) {
+        if (scene_render(scene, use_fbo, width, height)) {
+            printf("%-32s failed\n", r->name);
+            return 1;
+        }
+    }
+    glFinish();
+    double submit_ms = 0;
+    double gpu_ms = 0;
+    int render_failures = 0;
+    for (int f = 0; f < frames; ++f) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        gl_timer_begin(timer);
+        if (scene_render(scene, use_fbo, width, height)) ++render_failures;
+        gl_timer_end(timer);
+        submit_ms += gl_timer_elapsed_ms(&start);
+        gpu_ms += gl_timer_ms(timer);
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int f = 0; f < frames; ++f) {
+        if (scene_render(scene, use_fbo, width, height)) ++render_failures;
+    }
+    glFinish();
+    double total_ms = gl_timer_elapsed_ms(&start);
+    gl_state_bind_framebuffer(0);
+    glReadPixels(width / 2, height / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, r->center);
+    if (CHECK_GL()) return 1;
+    if (render_failures) {
+        printf("%-32s failed %d of %d frames\n", r->name, render_failures, 2 * frames);
+        return 1;
+    }
+    r->submit_ms = submit_ms / frames;
+    r->gpu_ms = timer->supported ? gpu_ms / frames : -1;
+    r->fps = frames * 1e3 / total_ms;
+    ++results_count;
+    // expect (1,1,1,255), the dark-grey quad
+    printf("%-32s submit %8.3f ms  GPU %9.3f ms  %9.1f fps  center: %d %d %d %d\n", r->name, r->submit_ms, r->gpu_ms, r->fps,
+        r->center[0], r->center[1], r->center[2], r->center[3]);
+    int wrong = r->center[0] != 1 || r->center[1] != 1 || r->center[2] != 1 || r->center[3] != 255;
+    if (wrong) printf("%-32s wrong center, expected 1 1 1 255\n", r->name);
+    if (!sink && !log) return wrong;
+    unsigned long sink_dropped = sink ? sink->dropped : 0;
+    unsigned long log_dropped = log ? log->dropped : 0;
+    size_t bytes = (size_t)width * height * 4;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int f = 0; f < frames; ++f) {
+        uint64_t render_ns = frame_log_now_ns();
+        if (scene_render(scene, use_fbo, width, height)) {
+            ++render_failures;
+            continue;
+        }
+        gl_state_bind_framebuffer(0);
+        // one readback: into the log's mapping, the sink copies from there
+        const uint8_t *pixels = 0;
+        struct frame_log_record *record = log ? frame_log_next(log, bytes) : 0;
+        if (record) {
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, FRAME_LOG_PIXELS(record));
+            record->render_ns = render_ns;
+            record->case_id = r - results;
+            record->format = GL_RGBA;
+            record->type = GL_UNSIGNED_BYTE;
+            record->width = width;
+            record->height = height;
+            snprintf(record->case_name, sizeof record->case_name, "%s", r->name);
+            frame_log_commit(log, record);
+            pixels = FRAME_LOG_PIXELS(record);
+        }
+        struct frame_sink_frame *frame = sink ? frame_sink_acquire(sink, bytes) : 0;
+        if (!frame) continue;
+        if (pixels) {
+            memcpy(frame->pixels, pixels, bytes);
+        } else {
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, frame->pixels);
+        }
+        frame->type = FRAME_SINK_RGBA8;
+        frame->width = width;
+        frame->height = height;
+        snprintf(frame->name, sizeof frame->name, "%s_%s_%dx%d_%03d", gl_api_name(api), mode, width, height, f);
+        frame_sink_submit(sink, frame);
+    }
+    printf("%-32s capture %.3f ms/frame", r->name, gl_timer_elapsed_ms(&start) / frames);
+    if (sink) printf(", dump %s: %lu of %d dropped", frame_sink_format_name(sink->format), sink->dropped - sink_dropped, frames);
+    if (log) printf(", log: %lu of %d dropped", log->dropped - log_dropped, frames);
+    if (render_failures) printf(", %d frames failed", render_failures);
+    printf("\n");
+    if (CHECK_GL()) return 1;
+    return wrong || render_failures;
+}
+
+static int write_json(const char *path, enum gl_api api, int srgb) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    time_t t = time(0);
+    char date[32];
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", localtime(&t));
+    fprintf(f, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": \"bench_frame\",\n", date);
+    fprintf(f, "    \"api\": \"%s\",\n    \"renderer\": \"%s\",\n    \"version\": \"%s\",\n    \"srgb_pbuffer\": %s\n  },\n",
+        gl_api_name(api), (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION), srgb ? "true" : "false");
+    fprintf(f, "  \"benchmarks\": [\n");
+    for (int i = 0; i < results_count; ++i) {
+        struct result *r = &results[i];
+        // real_time: wall time per frame of the unsynchronized run,
+        // cpu_time: the submit time
+        fprintf(f, "    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %d, \"real_time\": %.4f, \"cpu_time\": %.4f, "
+            "\"time_unit\": \"ms\", \"gpu_time\": %.4f, \"fps\": %.2f, \"center\": [%d, %d, %d, %d]}%s\n",
+            r->name, r->frames, 1e3 / r->fps, r->submit_ms, r->gpu_ms, r->fps,
+            r->center[0], r->center[1], r->center[2], r->center[3], i + 1 < results_count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    enum gl_api api = GL_API_OPENGL;
+    int frames = 20;
+    const char *json = 0;
+    const char *dump = 0;
+    int dump_format = FRAME_SINK_PNG;
+    const char *log_path = 0;
+    int log_records = 16;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--api=gles2")) {
+            api = GL_API_GLES2;
+        } else if (!strcmp(argv[i], "--api=gl")) {
+            api = GL_API_OPENGL;
+        } else if (!strncmp(argv[i], "--frames=", strlen("--frames="))) {
+            frames = atoi(argv[i] + strlen("--frames="));
+        } else if (!strncmp(argv[i], "--json=", strlen("--json="))) {
+            json = argv[i] + strlen("--json=");
+        } else if (!strncmp(argv[i], "--dump=", strlen("--dump="))) {
+            dump = argv[i] + strlen("--dump=");
+        } else if (!strncmp(argv[i], "--log=", strlen("--log="))) {
+            log_path = argv[i] + strlen("--log=");
+        } else if (!strncmp(argv[i], "--log_records=", strlen("--log_records="))) {
+            log_records = atoi(argv[i] + strlen("--log_records="));
+        } else if (!strncmp(argv[i], "--dump_format=", strlen("--dump_format=")) &&
+                (dump_format = frame_sink_format_by_name(argv[i] + strlen("--dump_format="))) >= 0) {
+            continue;
+        } else {
+            fprintf(stderr, "usage: bench_frame [--api=gl|gles2] [--frames=<n>] [--json=<file>] [--dump=<dir> [--dump_format=ppm|png|exr]]"
+                " [--log=<file> [--log_records=<n>]]\n");
+            return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+    int sizes[][2] = {{600, 600}, {1920, 1080}, {3840, 2160}};
+    struct egl_handles egl;
+    // the default framebuffer fits the largest size, smaller ones
+    // render to its lower-left corner
+    if (setup_egl(api, sizes[2][0], sizes[2][1], &egl)) return 1;
+    fprintf(stderr, "%s %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    if (!egl.srgb) fprintf(stderr, "no EGL_KHR_gl_colorspace: direct is not sRGB encoded\n");
+    struct scene scene;
+    if (scene_setup(&scene, api, GLVersion.major, sizes[0][0], sizes[0][1], 0)) return 1;
+    struct gl_timer timer;
+    gl_timer_setup(&timer, api);
+    struct frame_sink sink;
+    if (dump && frame_sink_setup(&sink, dump, dump_format, DUMP_SLOTS, (size_t)sizes[2][0] * sizes[2][1] * 4)) return 1;
+    // every record fits the largest frame benched
+    uint64_t max_frame_bytes = 0;
+    for (int i = 0; i < 3; ++i) {
+        uint64_t bytes = (uint64_t)sizes[i][0] * sizes[i][1] * 4;
+        if (bytes > max_frame_bytes) max_frame_bytes = bytes;
+    }
+    struct frame_log log;
+    if (log_path) {
+        if (frame_log_create(&log, log_path, log_records > 0 ? log_records : 1, max_frame_bytes)) return 1;
+        fprintf(stderr, "log %s: %llu records of %.1f MB, %.1f MB\n", log_path, (unsigned long long)log.header->records,
+            log.header->record_size / 1e6, log.map_size / 1e6);
+    }
+    int failed = 0;
+    for (int i = 0; i < 3; ++i) {
+        int width = sizes[i][0];
+        int height = sizes[i][1];
+        scene.present_strategy = PRESENT_QUAD;
+        if (bench(&egl, &scene, &timer, api, "direct", 0, 1, width, height, frames, dump ? &sink : 0, log_path ? &log : 0)) failed = 1;
+        if (bench(&egl, &scene, &timer, api, "fbo_ramp", 1, 0, width, height, frames, dump ? &sink : 0, log_path ? &log : 0)) failed = 1;
+        // and what glsrgb fbo would pick for the sRGB pbuffer, if not the ramp
+        if (scene.present.strategy != PRESENT_QUAD) {
+            char mode[32];
+            snprintf(mode, sizeof mode, "fbo_%s", present_strategy_name(scene.present.strategy));
+            scene.present_strategy = scene.present.strategy;
+            if (bench(&egl, &scene, &timer, api, mode, 1, 1, width, height, frames, dump ? &sink : 0, log_path ? &log : 0)) failed = 1;
+        }
+    }
+    if (dump) {
+        frame_sink_flush(&sink);
+        printf("dump %s: %lu frames written, %lu failed, %lu dropped\n", dump, sink.written, sink.failed, sink.dropped);
+        if (sink.failed) failed = 1;
+        frame_sink_teardown(&sink);
+    }
+    if (log_path) {
+        printf("log %s: %llu frames, %lu dropped\n", log_path, (unsigned long long)log.header->count, log.dropped);
+        if (frame_log_close(&log)) failed = 1;
+    }
+    if (json && write_json(json, api, egl.srgb)) failed = 1;
+    gl_timer_teardown(&timer);
+    scene_teardown(&scene);
+    teardown_egl(&egl);
+    return failed;
+}
@@ -0,0 +1,232 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "blend_sweep.h"
+#include "gl_error.h"
+#include "gl_state.h"
+#include "gl_timer.h"
+#include "quadtest.h"
+#include "srgb.h"
+
+struct blend_func {
+    GLenum src_factor;
+    GLenum dst_factor;
+    const char *name;
+};
+
+static const struct blend_func funcs[BLEND_SWEEP_FUNCS] = {
+    // quadtest_render's, the one the README is about
+    {GL_ONE, GL_ONE, "one,one"},
+    {GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, "src_alpha,one_minus_src_alpha"},
+    {GL_ONE, GL_ONE_MINUS_SRC_ALPHA, "one,one_minus_src_alpha"},
+    {GL_DST_COLOR, GL_ZERO, "dst_color,zero"},
+};
+
+static const char *const fsh_body =
+    "precision highp float;\n"
+    "precision highp int;\n"
+    "uniform highp sampler2D tex;\n"
+    "uniform int columns;\n"
+    "uniform int first_alpha;\n"
+    "out vec4 fragment_color;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    int alpha = first_alpha + (p.y / 256) * columns + p.x / 256;\n"
+    "    fragment_color = texelFetch(tex, ivec2(p.x - p.x / 256 * 256, alpha), 0);\n"
+    "}\n";
+
+const char *blend_sweep_func_name(int func) {
+    return func >= 0 && func < BLEND_SWEEP_FUNCS ? funcs[func].name : "unknown";
+}
+
+int blend_sweep_setup(struct blend_sweep *sweep, enum gl_api api) {
+    sweep->fullscreen.program = 0;
+    sweep->fullscreen.vertex_array = 0;
+    sweep->src_texture = 0;
+    sweep->expected = 0;
+    int is_gl = api == GL_API_OPENGL;
+    sweep->supported = is_gl ? GLVersion.major > 3 || (GLVersion.major == 3 && GLVersion.minor >= 3) : GLVersion.major >= 3;
+    if (!sweep->supported) {
+        fprintf(stderr, "no texelFetch, no blend sweep\n");
+        return 1;
+    }
+    if (fullscreen_setup(&sweep->fullscreen, api, fsh_body)) {
+        fprintf(stderr, "failed to build the blend sweep program\n");
+        exit(1);
+    }
+    GLuint program = sweep->fullscreen.program;
+    gl_state_use_program(program);
+    glUniform1i(glGetUniformLocation(program, "tex"), 0);
+    sweep->columns_location = glGetUniformLocation(program, "columns");
+    sweep->first_alpha_location = glGetUniformLocation(program, "first_alpha");
+    uint8_t *pixels = malloc(256 * 256 * 4);
+    sweep->expected = malloc(256 * 256 * 256);
+    if (!pixels || !sweep->expected) {
+        fprintf(stderr, "out of mem\n");
+        exit(1);
+    }
+    for (int alpha = 0; alpha < 256; ++alpha) {
+        for (int src = 0; src < 256; ++src) {
+            uint8_t *pixel = pixels + (alpha * 256 + src) * 4;
+            pixel[0] = pixel[1] = pixel[2] = src;
+            pixel[3] = alpha;
+        }
+    }
+    sweep->src_texture = create_srgb8_a8_texture(pixels, 256, 256);
+    free(pixels);
+    // blocks per row, as many as a target (and viewport) can hold
+    GLint max_size = 0;
+    GLint max_viewport[2] = {0, 0};
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, max_viewport);
+    if (max_viewport[0] < max_size) max_size = max_viewport[0];
+    if (max_viewport[1] < max_size) max_size = max_viewport[1];
+    sweep->columns = 16;
+    while (sweep->columns > 1 && sweep->columns * 256 > max_size) {
+        sweep->columns /= 2;
+    }
+    if (CHECK_GL_STAGE("blend_sweep_setup")) return 1;
+    return 0;
+}
+
+// first code whose encode threshold x reaches, thresholds[0] is below
+// everything: branch free, so the compiler can vectorize the dst loop
+static void encode_row(const float *restrict dst_linear, float base, float slope, const float *restrict thresholds,
+        uint8_t *restrict out) {
+    for (int dst = 0; dst < 256; ++dst) {
+        float x = base + slope * dst_linear[dst];
+        int code = 0;
+        for (int step = 128; step; step >>= 1) {
+            code += thresholds[code + step] <= x ? step : 0;
+        }
+        out[dst] = code;
+    }
+}
+
+// the expected codes of every combination, blended in linear: each
+// (alpha, src) is base + slope * dst in linear for all four functions
+static void reference(struct blend_sweep *sweep, const struct blend_func *func) {
+    float linear[256];
+    float thresholds[256];
+    for (int i = 0; i < 256; ++i) {
+        linear[i] = srgb_to_linear(i / 255.0f);
+        // the linear value from which code i is the nearest encode
+        thresholds[i] = i ? srgb_to_linear((i - 0.5f) / 255.0f) : -1.0f;
+    }
+    for (int alpha = 0; alpha < 256; ++alpha) {
+        float a = alpha / 255.0f;
+        float dst_factor = func->dst_factor == GL_ONE ? 1.0f : func->dst_factor == GL_ONE_MINUS_SRC_ALPHA ? 1.0f - a : 0.0f;
+        for (int src = 0; src < 256; ++src) {
+            float base, slope;
+            if (func->src_factor == GL_DST_COLOR) {
+                base = 0.0f;
+                slope = linear[src] + dst_factor;
+            } else {
+                base = linear[src] * (func->src_factor == GL_SRC_ALPHA ? a : 1.0f);
+                slope = dst_factor;
+            }
+            encode_row(linear, base, slope, thresholds, sweep->expected + (alpha * 256 + src) * 256);
+        }
+        // dst alpha is 1, so GL_DST_COLOR gives 1 for alpha
+        float out = a * (func->src_factor == GL_SRC_ALPHA ? a : 1.0f) + dst_factor;
+        sweep->expected_alpha[alpha] = out >= 1.0f ? 255 : out * 255.0f + 0.5f;
+    }
+}
+
+static void compare(struct blend_sweep *sweep, const uint8_t *frame, int size, int first_alpha, struct blend_sweep_result *result) {
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const uint8_t *pixel = frame + ((size_t)y * size + x) * 4;
+            int alpha = first_alpha + (y / 256) * sweep->columns + x / 256;
+            int src = x % 256;
+            int dst = y % 256;
+            int expected = sweep->expected[(alpha * 256 + src) * 256 + dst];
+            int diff = abs(pixel[3] - sweep->expected_alpha[alpha]);
+            for (int c = 0; c < 3; ++c) {
+                int d = abs(pixel[c] - expected);
+                if (d > diff) diff = d;
+            }
+            if (diff == 0) {
+                ++result->exact;
+            } else if (diff == 1) {
+                ++result->off_by_one;
+            } else {
+                ++result->wrong;
+            }
+            if (diff > result->max_diff) {
+                result->max_diff = diff;
+                result->worst_src = src;
+                result->worst_dst = dst;
+                result->worst_alpha = alpha;
+            }
+        }
+    }
+}
+
+int blend_sweep_run(struct blend_sweep *sweep, struct rt_pool *pool, int func, struct blend_sweep_result *result) {
+    struct blend_sweep_result r = {0};
+    *result = r;
+    if (!sweep->supported || func < 0 || func >= BLEND_SWEEP_FUNCS) return 1;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    reference(sweep, &funcs[func]);
+    r.cpu_ms = gl_timer_elapsed_ms(&start);
+    int size = sweep->columns * 256;
+    struct fborender *target = rt_pool_acquire(pool, GL_SRGB8_ALPHA8, size, size, 0);
+    // a row of blocks of dst, x = src, y = dst, opaque
+    uint8_t *dst_row = malloc((size_t)size * 256 * 4);
+    uint8_t *frame = malloc((size_t)size * size * 4);
+    if (!target || !dst_row || !frame) {
+        fprintf(stderr, "blend_sweep_run: no %dx%d target\n", size, size);
+        if (target) rt_pool_release(pool, target);
+        free(dst_row);
+        free(frame);
+        return 1;
+    }
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < size; ++x) {
+            uint8_t *pixel = dst_row + ((size_t)y * size + x) * 4;
+            pixel[0] = pixel[1] = pixel[2] = y;
+            pixel[3] = 255;
+        }
+    }
+    int per_draw = sweep->columns * sweep->columns;
+    for (int first_alpha = 0; first_alpha < 256; first_alpha += per_draw) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        gl_state_bind_texture(0, GL_TEXTURE_2D, target->texture);
+        for (int row = 0; row < sweep->columns; ++row) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row * 256, size, 256, GL_RGBA, GL_UNSIGNED_BYTE, dst_row);
+        }
+        gl_state_bind_framebuffer(target->fbo);
+        glViewport(0, 0, size, size);
+        gl_state_enable(GL_CULL_FACE, 0);
+        gl_state_enable(GL_DEPTH_TEST, 0);
+        gl_state_enable(GL_BLEND, 1);
+        gl_state_blend_func(funcs[func].src_factor, funcs[func].dst_factor);
+        gl_state_use_program(sweep->fullscreen.program);
+        glUniform1i(sweep->columns_location, sweep->columns);
+        glUniform1i(sweep->first_alpha_location, first_alpha);
+        gl_state_bind_texture(0, GL_TEXTURE_2D, sweep->src_texture);
+        fullscreen_draw(&sweep->fullscreen);
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, frame);
+        r.gpu_ms += gl_timer_elapsed_ms(&start);
+        if (CHECK_GL()) break;
+        compare(sweep, frame, size, first_alpha, &r);
+    }
+    gl_state_bind_framebuffer(0);
+    rt_pool_release(pool, target);
+    free(dst_row);
+    free(frame);
+    *result = r;
+    // a draw that failed leaves combinations uncompared
+    return r.exact + r.off_by_one + r.wrong != 256L * 256 * 256;
+}
+
+void blend_sweep_teardown(struct blend_sweep *sweep) {
+    fullscreen_teardown(&sweep->fullscreen);
+    if (sweep->src_texture) gl_state_delete_textures(1, &sweep->src_texture);
+    free(sweep->expected);
+    sweep->expected = 0;
+    CHECK_GL();
+}
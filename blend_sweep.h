@@ -0,0 +1,58 @@
+//  MIT license
+#ifndef BLEND_SWEEP_H
+#define BLEND_SWEEP_H
+
+#include <stdint.h>
+#include "glad/glad.h"
+#include "fullscreen.h"
+#include "gl_load.h"
+#include "rt_pool.h"
+
+// Every (src, dst, alpha) sRGB8 combination of a blend function, 2^24 of
+// them, blended by the GPU into an sRGB8_ALPHA8 target and compared with
+// the result computed on the CPU in linear space. The target holds one
+// pixel per combination: 256x256 blocks (x = src, y = dst), one block
+// per alpha, as many blocks per draw as the target size allows (all of
+// them in one 4096x4096 draw). dst is uploaded as the target's content
+// (opaque), src comes from a 256x256 sRGB8_ALPHA8 texture (x = src, y =
+// alpha, not pre-multiplied), one fullscreen draw blends all of it and
+// a single glReadPixels brings it back.
+// Needs texelFetch (GL 3.3, GL ES 3.0).
+#define BLEND_SWEEP_FUNCS 4
+
+struct blend_sweep_result {
+    long exact;
+    long off_by_one;
+    long wrong;
+    int max_diff;
+    // combination of the first max_diff
+    int worst_src, worst_dst, worst_alpha;
+    // upload + blend + readback, and the CPU reference
+    double gpu_ms, cpu_ms;
+};
+
+struct blend_sweep {
+    int supported;
+    struct fullscreen fullscreen;
+    GLuint src_texture;
+    GLint columns_location;
+    GLint first_alpha_location;
+    // blocks per target row, target size is 256 * columns
+    int columns;
+    // CPU reference: rgb code of [alpha][src][dst], alpha code of [alpha]
+    uint8_t *expected;
+    uint8_t expected_alpha[256];
+};
+
+// e.g. "one,one", "src_alpha,one_minus_src_alpha"
+const char *blend_sweep_func_name(int func);
+// 1 if not supported, blend_sweep_run then fails
+int blend_sweep_setup(struct blend_sweep *sweep, enum gl_api api);
+// all combinations of func (0 .. BLEND_SWEEP_FUNCS - 1), the target comes
+// from pool; GL_FRAMEBUFFER_SRGB must be on for GL. 1 if not all of them
+// could be compared, result is then zeroed or partial; wrong combinations
+// are in result, not a failure of the run
+int blend_sweep_run(struct blend_sweep *sweep, struct rt_pool *pool, int func, struct blend_sweep_result *result);
+void blend_sweep_teardown(struct blend_sweep *sweep);
+
+#endif
@@ -0,0 +1,8 @@
+#!/usr/bin/env sh
+glad=glad-4.6
+glad_glx=glad-glx-1.4
+sources="main.c scene.c quadtest.c pattern_atlas.c fborender.c rt_pool.c msaa.c gl_timer.c srgb.c ref_raster.c blend_sweep.c decode_check.c fullscreen.c golden.c frame_diff.c frame_sink.c frame_log.c tile_pool.c gl_error.c gl_compile.c gl_debug.c gl_ext.c gl_state.c compute_post.c present.c"
+gcc -I ${glad}/include -I ${glad_glx}/include -I . -Wall -g -c -o ${glad}/src/glad.o ${glad}/src/glad.c
+gcc -I ${glad}/include -I ${glad_glx}/include -I . -Wall -g -c -o ${glad_glx}/src/glad_glx.o ${glad_glx}/src/glad_glx.c
+./gen_gl_procs.sh ${glad}/include ${glad_glx}/include ${sources} > gl_procs.h
+gcc -I ${glad}/include -I ${glad_glx}/include -I . -Wall -pedantic -g ${CFLAGS} -o glsrgb ${glad}/src/glad.o ${glad_glx}/src/glad_glx.o ${sources} gl_load.c -lX11 -lGL -ldl -lm -lz -pthread
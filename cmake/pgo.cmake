@@ -0,0 +1,48 @@
+# Two stage profile guided build, run by the pgo target (cmake -P):
+# 1. configure BINARY_DIR/pgo with GLSRGB_PGO=GENERATE and build it
+# 2. run each of TRAIN (| separated "binary args") there, which writes
+#    the profiles to BINARY_DIR/pgo-profiles
+# 3. reconfigure the same directory with GLSRGB_PGO=USE and rebuild
+# Both stages build in the same directory: gcc finds the profile of an
+# object by the object's path.
+set(build ${BINARY_DIR}/pgo)
+set(profiles ${BINARY_DIR}/pgo-profiles)
+file(REMOVE_RECURSE ${profiles})
+
+function(run)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(result)
+        string(REPLACE ";" " " command "${ARGN}")
+        message(FATAL_ERROR "pgo: failed (${result}): ${command}")
+    endif()
+endfunction()
+
+foreach(stage GENERATE USE)
+    message(STATUS "pgo: ${stage} build in ${build}")
+    run(${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${build} -G ${GENERATOR}
+        -DCMAKE_BUILD_TYPE=Release
+        -DCMAKE_C_COMPILER=${C_COMPILER}
+        -DGLSRGB_LTO=${LTO}
+        -DGL_CHECK_MODE=${GL_CHECK_MODE}
+        -DGL_STATE_CACHE=${GL_STATE_CACHE}
+        -DGL_LOAD_ALL=${GL_LOAD_ALL}
+        -DGLSRGB_PGO=${stage}
+        -DGLSRGB_PGO_DIR=${profiles})
+    run(${CMAKE_COMMAND} --build ${build})
+    if(stage STREQUAL "USE")
+        break()
+    endif()
+    string(REPLACE "|" ";" runs "${TRAIN}")
+    foreach(train ${runs})
+        separate_arguments(args UNIX_COMMAND "${train}")
+        list(GET args 0 binary)
+        list(REMOVE_AT args 0)
+        message(STATUS "pgo: training with ${train}")
+        run(${build}/${binary} ${args})
+    endforeach()
+    if(C_COMPILER_ID MATCHES "Clang")
+        file(GLOB raw ${profiles}/*.profraw)
+        run(llvm-profdata merge -output=${profiles}/default.profdata ${raw})
+    endif()
+endforeach()
+message(STATUS "pgo: ${build}/glsrgb built from the profiles in ${profiles}")
@@ -0,0 +1,93 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include "compute_post.h"
+#include "gl_compile.h"
+#include "gl_error.h"
+#include "gl_state.h"
+
+static const int tiles[COMPUTE_POST_TILES] = {8, 16};
+
+// tex on unit 0 and ramp on unit 1, as the fragment path binds them
+static const char *const csh_body =
+    "layout(local_size_x = TILE, local_size_y = TILE) in;\n"
+    "layout(binding = 0) uniform highp sampler2D tex;\n"
+    "layout(binding = 1) uniform lowp sampler2D ramp;\n"
+    "layout(binding = 0, rgba8) writeonly uniform highp image2D dst;\n"
+    "uniform ivec2 size;\n"
+    "void main() {\n"
+    // the dispatch is rounded up to whole tiles
+    "    ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+    "    if (any(greaterThanEqual(p, size))) return;\n"
+    "    vec4 tx = texelFetch(tex, p, 0);\n"
+    // NOTE: texture is assumed to be premultiplied alpha
+    // no derivatives in compute, so an explicit lod
+    "    vec4 srgb_a = vec4(textureLod(ramp, vec2(tx.r, 0.0), 0.0).a,\n"
+    "                       textureLod(ramp, vec2(tx.g, 0.0), 0.0).a,\n"
+    "                       textureLod(ramp, vec2(tx.b, 0.0), 0.0).a,\n"
+    "                       tx.a);\n"
+    "    imageStore(dst, p, srgb_a);\n"
+    "}\n";
+
+int compute_post_tile(int i) {
+    return tiles[i];
+}
+
+int compute_post_setup(struct compute_post *post, enum gl_api api) {
+    for (int i = 0; i < COMPUTE_POST_TILES; ++i) {
+        post->programs[i] = 0;
+        post->size_locations[i] = -1;
+    }
+    post->supported = api == GL_API_OPENGL && (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3)) &&
+        glDispatchCompute && glBindImageTexture && glMemoryBarrier;
+    if (!post->supported) {
+        fprintf(stderr, "no compute shaders, no compute post-process\n");
+        return 1;
+    }
+    for (int i = 0; i < COMPUTE_POST_TILES; ++i) {
+        char src[2048];
+        snprintf(src, sizeof src, "#version 430\n#define TILE %d\n%s", tiles[i], csh_body);
+        if (gl_compile_compute_program(src, &post->programs[i])) {
+            fprintf(stderr, "failed to build the %dx%d compute post-process\n", tiles[i], tiles[i]);
+            exit(1);
+        }
+        post->size_locations[i] = glGetUniformLocation(post->programs[i], "size"); CHECK_GL();
+    }
+    CHECK_GL_STAGE("compute_post_setup");
+    return 0;
+}
+
+int compute_post_render(struct compute_post *post, int tile, struct fborender *src, GLuint ramp, struct fborender *dst) {
+    if (!post->supported) return 1;
+    int i = 0;
+    while (i < COMPUTE_POST_TILES && tiles[i] != tile) ++i;
+    if (i == COMPUTE_POST_TILES || dst->format != GL_RGBA8 || !dst->texture || !src->texture ||
+        dst->storage_width < src->width || dst->storage_height < src->height) {
+        fprintf(stderr, "compute_post_render: no %dx%d program or unusable targets\n", tile, tile);
+        return 1;
+    }
+    gl_state_use_program(post->programs[i]);
+    glUniform2i(post->size_locations[i], src->width, src->height);
+    gl_state_bind_texture(0, GL_TEXTURE_2D, src->texture);
+    gl_state_bind_texture(1, GL_TEXTURE_2D, ramp);
+    glBindImageTexture(0, dst->texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glDispatchCompute((src->width + tile - 1) / tile, (src->height + tile - 1) / tile, 1);
+    // the stores must land before dst is blitted or sampled
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    dst->width = src->width;
+    dst->height = src->height;
+    return CHECK_GL();
+}
+
+void compute_post_present(struct fborender *src) {
+    gl_state_bind_framebuffers(src->fbo, 0);
+    glBlitFramebuffer(0, 0, src->width, src->height, 0, 0, src->width, src->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    gl_state_bind_framebuffer(0);
+}
+
+void compute_post_teardown(struct compute_post *post) {
+    for (int i = 0; i < COMPUTE_POST_TILES; ++i) {
+        if (post->programs[i]) gl_state_delete_program(post->programs[i]);
+        post->programs[i] = 0;
+    }
+}
@@ -0,0 +1,34 @@
+//  MIT license
+#ifndef COMPUTE_POST_H
+#define COMPUTE_POST_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+#include "fborender.h"
+
+// The linear -> sRGB post-process as a compute pass instead of a
+// fullscreen quad: one invocation per pixel, in tile x tile work groups,
+// texelFetch from the fbo target, encode through the same ramp texture
+// as the fragment path and imageStore into a GL_RGBA8 target, which is
+// then blitted to the default framebuffer.
+// Needs compute shaders and image load/store (GL 4.3), not used on GL ES.
+#define COMPUTE_POST_TILES 2
+
+struct compute_post {
+    int supported;
+    GLuint programs[COMPUTE_POST_TILES];
+    GLint size_locations[COMPUTE_POST_TILES];
+};
+
+// work group width and height of program i: 8, 16
+int compute_post_tile(int i);
+// 1 if not supported, the other calls are then no-ops
+int compute_post_setup(struct compute_post *post, enum gl_api api);
+// encodes the rendered part of src into dst (GL_RGBA8, fitting src's size)
+// with the program of tile (one of compute_post_tile)
+int compute_post_render(struct compute_post *post, int tile, struct fborender *src, GLuint ramp, struct fborender *dst);
+// glBlitFramebuffer of the rendered part of src to the default framebuffer
+void compute_post_present(struct fborender *src);
+void compute_post_teardown(struct compute_post *post);
+
+#endif
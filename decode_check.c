@@ -0,0 +1,160 @@
+//  MIT license
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "decode_check.h"
+#include "gl_error.h"
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "quadtest.h"
+#include "srgb.h"
+
+static const char *const path_names[DECODE_CHECK_PATHS] = {"nearest", "linear", "mipmap"};
+
+// row = path, x = code; explicit lods, the branches are not uniform
+static const char *const fsh_body =
+    "precision highp float;\n"
+    "uniform highp sampler2D nearest_texture;\n"
+    "uniform highp sampler2D linear_texture;\n"
+    "uniform highp sampler2D mipmap_texture;\n"
+    "out vec4 fragment_color;\n"
+    "void main() {\n"
+    "    float u = gl_FragCoord.x / 256.0;\n"
+    "    int path = int(gl_FragCoord.y);\n"
+    "    if (path == 0) {\n"
+    "        fragment_color = textureLod(nearest_texture, vec2(u, 0.5), 0.0);\n"
+    "    } else if (path == 1) {\n"
+    "        fragment_color = textureLod(linear_texture, vec2(u + 0.5 / 256.0, 0.5), 0.0);\n"
+    "    } else {\n"
+    "        fragment_color = textureLod(mipmap_texture, vec2(u, 0.5), 1.0);\n"
+    "    }\n"
+    "}\n";
+
+const char *decode_check_path_name(int path) {
+    return path >= 0 && path < DECODE_CHECK_PATHS ? path_names[path] : "unknown";
+}
+
+// codes 0..255 along x, reversed: 255..0
+static void code_pixels(uint8_t *pixels, int width, int height, int reversed) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t *pixel = pixels + (y * width + x) * 4;
+            int code = x * 256 / width;
+            pixel[0] = pixel[1] = pixel[2] = pixel[3] = reversed ? 255 - code : code;
+        }
+    }
+}
+
+int decode_check_setup(struct decode_check *check, enum gl_api api) {
+    check->fullscreen.program = 0;
+    check->fullscreen.vertex_array = 0;
+    for (int i = 0; i < DECODE_CHECK_PATHS; ++i) {
+        check->textures[i] = 0;
+    }
+    int is_gl = api == GL_API_OPENGL;
+    check->supported = is_gl ? GLVersion.major > 3 || (GLVersion.major == 3 && GLVersion.minor >= 3)
+        : GLVersion.major >= 3 && glsrgb_has_extension("GL_EXT_color_buffer_float");
+    if (!check->supported) {
+        fprintf(stderr, "no float render target, no decode check\n");
+        return 1;
+    }
+    if (fullscreen_setup(&check->fullscreen, api, fsh_body)) {
+        fprintf(stderr, "failed to build the decode check program\n");
+        exit(1);
+    }
+    GLuint program = check->fullscreen.program;
+    gl_state_use_program(program);
+    glUniform1i(glGetUniformLocation(program, "nearest_texture"), 0);
+    glUniform1i(glGetUniformLocation(program, "linear_texture"), 1);
+    glUniform1i(glGetUniformLocation(program, "mipmap_texture"), 2);
+    uint8_t pixels[512 * 2 * 4];
+    code_pixels(pixels, 256, 1, 0);
+    check->textures[0] = create_srgb8_a8_texture(pixels, 256, 1);
+    check->textures[1] = create_srgb8_a8_texture(pixels, 256, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // the codes at level 1, reversed at level 0: reading the wrong level
+    // (or blending in the other one) is far off
+    code_pixels(pixels, 512, 2, 1);
+    check->textures[2] = create_srgb8_a8_texture(pixels, 512, 2);
+    code_pixels(pixels, 256, 1, 0);
+    glTexImage2D(GL_TEXTURE_2D, 1, GL_SRGB8_ALPHA8, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    if (CHECK_GL_STAGE("decode_check_setup")) return 1;
+    return 0;
+}
+
+static double expected_value(const float decode[256], int path, int code) {
+    // linear: halfway to the next code, clamped at the last one
+    if (path == 1 && code < 255) return (decode[code] + (double)decode[code + 1]) * 0.5;
+    return decode[code];
+}
+
+static double expected_alpha(int path, int code) {
+    if (path == 1 && code < 255) return (code + 0.5) / 255.0;
+    return code / 255.0;
+}
+
+int decode_check_run(struct decode_check *check, struct rt_pool *pool, struct decode_check_result results[DECODE_CHECK_PATHS]) {
+    memset(results, 0, sizeof(struct decode_check_result) * DECODE_CHECK_PATHS);
+    if (!check->supported) return 1;
+    struct fborender *target = rt_pool_acquire(pool, GL_RGBA32F, 256, DECODE_CHECK_PATHS, 0);
+    if (!target) {
+        fprintf(stderr, "decode_check_run: no rgba32f target\n");
+        return 1;
+    }
+    gl_state_bind_framebuffer(target->fbo);
+    glViewport(0, 0, 256, DECODE_CHECK_PATHS);
+    gl_state_enable(GL_CULL_FACE, 0);
+    gl_state_enable(GL_DEPTH_TEST, 0);
+    gl_state_enable(GL_BLEND, 0);
+    for (int i = 0; i < DECODE_CHECK_PATHS; ++i) {
+        gl_state_bind_texture(i, GL_TEXTURE_2D, check->textures[i]);
+    }
+    fullscreen_draw(&check->fullscreen);
+    float frame[256 * DECODE_CHECK_PATHS * 4];
+    glReadPixels(0, 0, 256, DECODE_CHECK_PATHS, GL_RGBA, GL_FLOAT, frame);
+    gl_state_bind_framebuffer(0);
+    rt_pool_release(pool, target);
+    if (CHECK_GL()) return 1;
+    float decode[256];
+    for (int code = 0; code < 256; ++code) {
+        decode[code] = srgb_to_linear(code / 255.0f);
+    }
+    for (int path = 0; path < DECODE_CHECK_PATHS; ++path) {
+        struct decode_check_result r = {0};
+        for (int code = 0; code < 256; ++code) {
+            const float *pixel = frame + (path * 256 + code) * 4;
+            double expected = expected_value(decode, path, code);
+            // half the gap to the closest neighbouring decoded code
+            double gap = code ? decode[code] - (double)decode[code - 1] : decode[1] - (double)decode[0];
+            if (code < 255 && decode[code + 1] - (double)decode[code] < gap) gap = decode[code + 1] - (double)decode[code];
+            double error = 0;
+            for (int c = 0; c < 3; ++c) {
+                double e = fabs(pixel[c] - expected);
+                if (e > error) error = e;
+            }
+            if (error > gap * 0.5) ++r.off;
+            if (error > r.max_error) {
+                r.max_error = error;
+                r.worst_code = code;
+            }
+            double error_alpha = fabs(pixel[3] - expected_alpha(path, code));
+            if (error_alpha > r.max_error_alpha) r.max_error_alpha = error_alpha;
+        }
+        results[path] = r;
+    }
+    return 0;
+}
+
+void decode_check_teardown(struct decode_check *check) {
+    fullscreen_teardown(&check->fullscreen);
+    for (int i = 0; i < DECODE_CHECK_PATHS; ++i) {
+        if (check->textures[i]) gl_state_delete_textures(1, &check->textures[i]);
+        check->textures[i] = 0;
+    }
+    CHECK_GL();
+}
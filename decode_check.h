@@ -0,0 +1,49 @@
+//  MIT license
+#ifndef DECODE_CHECK_H
+#define DECODE_CHECK_H
+
+#include "glad/glad.h"
+#include "fullscreen.h"
+#include "gl_load.h"
+#include "rt_pool.h"
+
+// Every sRGB8 code decoded by the texture unit, through each sampling
+// path, compared with the decode table (srgb_to_linear). Codes 0..255
+// (alpha = code) are a 256 texel row of a GL_SRGB8_ALPHA8 texture,
+// sampled into one row per path of a 256x3 GL_RGBA32F target, all in one
+// draw and one glReadPixels:
+// - nearest: at the texel centers, GL_NEAREST
+// - linear: halfway between code and code + 1, GL_LINEAR, expects the
+//   average of both decoded values (decoded before filtering)
+// - mipmap: level 1 of a two level texture (level 0 has the codes
+//   reversed), textureLod 1 with GL_LINEAR_MIPMAP_LINEAR, at the centers
+// Needs GL 3.3, or GL ES 3.0 with GL_EXT_color_buffer_float.
+#define DECODE_CHECK_PATHS 3
+
+struct decode_check_result {
+    // largest |sampled - expected| of rgb, and of alpha (not decoded)
+    double max_error;
+    double max_error_alpha;
+    // code of the first max_error
+    int worst_code;
+    // codes further from the expected value than half the distance to
+    // the next decoded code, i.e. that could be taken for another code
+    int off;
+};
+
+struct decode_check {
+    int supported;
+    struct fullscreen fullscreen;
+    GLuint textures[DECODE_CHECK_PATHS];
+};
+
+// e.g. "nearest", "mipmap"
+const char *decode_check_path_name(int path);
+// 1 if not supported, decode_check_run then fails
+int decode_check_setup(struct decode_check *check, enum gl_api api);
+// results of every path, the target comes from pool; 1 if the draw or
+// readback failed (results zeroed), codes off are in results only
+int decode_check_run(struct decode_check *check, struct rt_pool *pool, struct decode_check_result results[DECODE_CHECK_PATHS]);
+void decode_check_teardown(struct decode_check *check);
+
+#endif
@@ -0,0 +1,246 @@
+//  MIT license
+#include <stdio.h>
+#include <string.h>
+#include "fborender.h"
+#include "gl_error.h"
+#include "gl_ext.h"
+#include "gl_state.h"
+
+struct fborender_format_info {
+    GLenum format;
+    const char *name;
+    // for glTexImage2D where there is no texture storage
+    GLenum base_format;
+    GLenum type;
+};
+
+static const struct fborender_format_info formats[] = {
+    {GL_SRGB8_ALPHA8, "srgb8_a8", GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA8, "rgba8", GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA16F, "rgba16f", GL_RGBA, GL_HALF_FLOAT},
+    {GL_RGBA32F, "rgba32f", GL_RGBA, GL_FLOAT},
+    {GL_RGB10_A2, "rgb10_a2", GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV},
+    {GL_R11F_G11F_B10F, "r11f_g11f_b10f", GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV},
+};
+
+#define FORMATS_COUNT (sizeof formats / sizeof formats[0])
+
+static const struct fborender_format_info *format_info(GLenum format) {
+    for (size_t i = 0; i < FORMATS_COUNT; ++i) {
+        if (formats[i].format == format) return &formats[i];
+    }
+    return 0;
+}
+
+int fborender_format_count(void) {
+    return FORMATS_COUNT;
+}
+
+GLenum fborender_format(int i) {
+    return formats[i].format;
+}
+
+const char *fborender_format_name(GLenum format) {
+    const struct fborender_format_info *info = format_info(format);
+    return info ? info->name : "unknown";
+}
+
+GLenum fborender_format_by_name(const char *name) {
+    for (size_t i = 0; i < FORMATS_COUNT; ++i) {
+        if (!strcmp(formats[i].name, name)) return formats[i].format;
+    }
+    return 0;
+}
+
+int fborender_format_supported(enum gl_api api, GLenum format) {
+    int major = GLVersion.major, minor = GLVersion.minor;
+    // GL 3.0 made all of them color renderable
+    if (api == GL_API_OPENGL) return major >= 3 || format == GL_RGBA8;
+    int es3 = major >= 3;
+    // EXT_color_buffer_float is core in GL ES 3.2
+    int es_float = (es3 && glsrgb_has_extension("GL_EXT_color_buffer_float")) || major > 3 || (major == 3 && minor >= 2);
+    switch (format) {
+        case GL_SRGB8_ALPHA8: return es3 || glsrgb_has_extension("GL_EXT_sRGB");
+        case GL_RGBA8: return es3 || glsrgb_has_extension("GL_OES_rgb8_rgba8");
+        case GL_RGB10_A2: return es3;
+        case GL_RGBA16F: return es_float || (es3 && glsrgb_has_extension("GL_EXT_color_buffer_half_float"));
+        case GL_RGBA32F:
+        case GL_R11F_G11F_B10F: return es_float;
+        default: return 0;
+    }
+}
+
+static int has_texture_storage(enum gl_api api) {
+    // core since GL 4.2 and GL ES 3.0 (gl_load resolves the EXT name on GLES2)
+    if (api == GL_API_OPENGL) return GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2);
+    return GLVersion.major >= 3 || glsrgb_has_extension("GL_EXT_texture_storage");
+}
+
+static int bucket(int size, int max_size) {
+    int b = 64;
+    while (b < size) b *= 2;
+    return b > max_size ? size : b;
+}
+
+// a view outlives neither the storage it aliases nor the fborender
+static void delete_view(struct fborender *test) {
+    if (test->view_fbo) gl_state_delete_framebuffers(1, &test->view_fbo);
+    if (test->view) gl_state_delete_textures(1, &test->view);
+    test->view = 0;
+    test->view_fbo = 0;
+    test->view_format = 0;
+}
+
+// (re)creates the attachment at the storage size and attaches it
+static int allocate(struct fborender *test) {
+    delete_view(test);
+    if (test->texture) gl_state_delete_textures(1, &test->texture);
+    if (test->renderbuffer) glDeleteRenderbuffers(1, &test->renderbuffer);
+    test->texture = 0;
+    test->renderbuffer = 0;
+    gl_state_bind_framebuffer(test->fbo);
+    if (test->samples > 1) {
+        glGenRenderbuffers(1, &test->renderbuffer); CHECK_GL();
+        glBindRenderbuffer(GL_RENDERBUFFER, test->renderbuffer); CHECK_GL();
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, test->samples, test->format, test->storage_width, test->storage_height); CHECK_GL();
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, test->renderbuffer);
+    } else {
+        glGenTextures(1, &test->texture); CHECK_GL();
+        gl_state_bind_texture(0, GL_TEXTURE_2D, test->texture); CHECK_GL();
+        if (test->immutable && glTexStorage2D) {
+            glTexStorage2D(GL_TEXTURE_2D, 1, test->format, test->storage_width, test->storage_height); CHECK_GL();
+        } else {
+            const struct fborender_format_info *info = format_info(test->format);
+            glTexImage2D(GL_TEXTURE_2D, 0, test->format, test->storage_width, test->storage_height, 0, info->base_format, info->type, 0); CHECK_GL();
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, test->texture, 0);
+    }
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "failed create framebuffer, not complete? (%s, %d samples)\n", fborender_format_name(test->format), test->samples);
+        return 1;
+    }
+    ++test->reallocations;
+    fprintf(stderr, "fborender: %s %dx%d storage for %dx%d (%s, %d samples)\n", fborender_format_name(test->format), test->storage_width, test->storage_height,
+        test->width, test->height, test->samples > 1 ? "renderbuffer" : test->immutable ? "immutable" : "mutable", test->samples);
+    return 0;
+}
+
+int fborender_setup(struct fborender *test, enum gl_api api, GLenum format, int samples, int width, int height) {
+    if (!format_info(format)) {
+        fprintf(stderr, "fborender: unsupported format 0x%x\n", format);
+        return 1;
+    }
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size); CHECK_GL();
+    test->immutable = has_texture_storage(api);
+    test->format = format;
+    test->samples = samples;
+    test->texture = 0;
+    test->renderbuffer = 0;
+    test->view = 0;
+    test->view_fbo = 0;
+    test->view_format = 0;
+    test->width = width;
+    test->height = height;
+    test->storage_width = bucket(width, max_size);
+    test->storage_height = bucket(height, max_size);
+    test->reallocations = 0;
+    glGenFramebuffers(1, &test->fbo);
+    if (allocate(test)) {
+        fborender_teardown(test);
+        return 1;
+    }
+    if (CHECK_GL_STAGE("fborender_setup")) {
+        fborender_teardown(test);
+        return 1;
+    }
+    return 0;
+}
+
+int fborender_resize(struct fborender *test, int width, int height) {
+    if (test->width == width && test->height == height) return 0;
+    test->width = width;
+    test->height = height;
+    // shrinking, or growing within the bucket, keeps the allocation
+    if (fborender_fits(test, width, height)) return 0;
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size); CHECK_GL();
+    // never shrink a dimension, a drag back and forth would reallocate
+    if (width > test->storage_width) test->storage_width = bucket(width, max_size);
+    if (height > test->storage_height) test->storage_height = bucket(height, max_size);
+    if (allocate(test)) return 1;
+    if (CHECK_GL_STAGE("fborender_resize")) return 1;
+    return 0;
+}
+
+int fborender_fits(const struct fborender *test, int width, int height) {
+    return width <= test->storage_width && height <= test->storage_height;
+}
+
+int fborender_has_invalidate(enum gl_api api) {
+    if (!glInvalidateFramebuffer) return 0;
+    if (api == GL_API_OPENGL) {
+        if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3)) return 1;
+        return glsrgb_has_extension("GL_ARB_invalidate_subdata");
+    }
+    return GLVersion.major >= 3 || glsrgb_has_extension("GL_EXT_discard_framebuffer");
+}
+
+int fborender_has_texture_view(enum gl_api api) {
+    if (!glTextureView) return 0;
+    if (api == GL_API_OPENGL) {
+        if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3)) return 1;
+        return glsrgb_has_extension("GL_ARB_texture_view");
+    }
+    return glsrgb_has_extension("GL_OES_texture_view") || glsrgb_has_extension("GL_EXT_texture_view");
+}
+
+GLuint fborender_view_framebuffer(struct fborender *test, GLenum view_format) {
+    if (test->view_fbo && test->view_format == view_format) return test->view_fbo;
+    delete_view(test);
+    // views alias immutable storage only
+    if (!test->texture || !test->immutable || !glTexStorage2D) return 0;
+    glGenTextures(1, &test->view); CHECK_GL();
+    glTextureView(test->view, GL_TEXTURE_2D, test->texture, view_format, 0, 1, 0, 1);
+    if (CHECK_GL()) {
+        delete_view(test);
+        return 0;
+    }
+    gl_state_bind_texture(0, GL_TEXTURE_2D, test->view);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &test->view_fbo);
+    gl_state_bind_framebuffer(test->view_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, test->view, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "fborender: %s view of %s storage not renderable\n", fborender_format_name(view_format), fborender_format_name(test->format));
+        delete_view(test);
+        return 0;
+    }
+    test->view_format = view_format;
+    CHECK_GL_STAGE("fborender_view_framebuffer");
+    return test->view_fbo;
+}
+
+void fborender_invalidate_color(GLuint framebuffer) {
+    // GL_COLOR names the default framebuffer's color (GL_COLOR_EXT on GLES2)
+    GLenum attachment = framebuffer ? GL_COLOR_ATTACHMENT0 : GL_COLOR;
+    gl_state_bind_framebuffer(framebuffer);
+    glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, &attachment); CHECK_GL();
+}
+
+void fborender_uv_scale(const struct fborender *test, GLfloat uv_scale[2]) {
+    uv_scale[0] = test->width / (GLfloat)test->storage_width;
+    uv_scale[1] = test->height / (GLfloat)test->storage_height;
+}
+
+void fborender_teardown(struct fborender *test) {
+    delete_view(test);
+    if (test->texture) gl_state_delete_textures(1, &test->texture);
+    if (test->renderbuffer) glDeleteRenderbuffers(1, &test->renderbuffer);
+    gl_state_delete_framebuffers(1, &test->fbo);
+}
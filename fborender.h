@@ -0,0 +1,65 @@
+//  MIT license
+#ifndef FBORENDER_H
+#define FBORENDER_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+
+// Offscreen color target. The texture is allocated in power-of-two
+// buckets with immutable storage (glTexStorage2D) when the context has
+// it, and only the lower-left width x height is rendered.
+// A resize that fits the allocation just records the new size, so a
+// window drag costs no reallocation; only growing past it reallocates.
+// With samples > 1 the attachment is a multisampled renderbuffer
+// instead (not sampleable, texture is 0).
+// view/view_fbo: a texture view of the storage in another format and its
+// framebuffer, made on demand (fborender_view_framebuffer).
+struct fborender {
+    GLuint texture;
+    GLuint renderbuffer;
+    GLuint fbo;
+    GLuint view;
+    GLuint view_fbo;
+    GLenum view_format;
+    GLenum format;
+    int samples;
+    int immutable;
+    // size rendered to, and of the allocation
+    int width, height;
+    int storage_width, storage_height;
+    unsigned long reallocations;
+};
+
+// the intermediate formats the harness compares, GL_SRGB8_ALPHA8 first
+int fborender_format_count(void);
+GLenum fborender_format(int i);
+const char *fborender_format_name(GLenum format);
+// 0 if no such name
+GLenum fborender_format_by_name(const char *name);
+// whether format is color renderable in the current context of api (GL
+// 3.0; GL ES 3.0, the float ones with GL_EXT_color_buffer_float or 3.2,
+// rgba16f also with GL_EXT_color_buffer_half_float)
+int fborender_format_supported(enum gl_api api, GLenum format);
+
+int fborender_setup(struct fborender *test, enum gl_api api, GLenum format, int samples, int width, int height);
+int fborender_resize(struct fborender *test, int width, int height);
+// whether resizing to width x height would keep the allocation
+int fborender_fits(const struct fborender *test, int width, int height);
+// glInvalidateFramebuffer (GL 4.3, GL ES 3.0), or on GLES2
+// glDiscardFramebufferEXT (gl_load resolves it under the core name)
+int fborender_has_invalidate(enum gl_api api);
+// glTextureView (GL 4.3 or GL_ARB_texture_view, GL_OES/EXT_texture_view)
+int fborender_has_texture_view(enum gl_api api);
+// framebuffer of a view of the texture as view_format, a format of the
+// same size and class (e.g. GL_RGBA8 for GL_SRGB8_ALPHA8): the same texels,
+// read and written without sRGB conversion. Made once per allocation,
+// needs immutable storage; 0 if it cannot be made.
+GLuint fborender_view_framebuffer(struct fborender *test, GLenum view_format);
+// binds framebuffer (0: the default one) and tells the driver its color
+// contents are dead: need not be loaded before, or stored after, a pass
+void fborender_invalidate_color(GLuint framebuffer);
+// scale from [0,1] uv to the rendered part of the texture
+void fborender_uv_scale(const struct fborender *test, GLfloat uv_scale[2]);
+void fborender_teardown(struct fborender *test);
+
+#endif
@@ -0,0 +1,237 @@
+//  MIT license
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "frame_diff.h"
+#include "srgb.h"
+#include "tile_pool.h"
+
+#define PI 3.14159265358979323846
+
+// what a thread adds up, merged once all tiles are done
+struct accumulator {
+    long long sum_srgb[4];
+    double sum_linear[4];
+    int max_srgb[4];
+    double max_linear[4];
+    long differing;
+    long over_one_step;
+    double sum_delta_e;
+    double max_delta_e;
+    int max_x, max_y;
+};
+
+struct job {
+    const uint8_t *a, *b;
+    uint8_t *heat;
+    int width, height;
+    float linear[256];
+    // one per tile_pool worker
+    struct accumulator accumulators[TILE_POOL_MAX_THREADS];
+};
+
+static void lab(const float linear[256], const uint8_t *pixel, double out[3]) {
+    double r = linear[pixel[0]], g = linear[pixel[1]], b = linear[pixel[2]];
+    // linear sRGB to XYZ, relative to the D65 white
+    double xyz[3] = {
+        (0.4124564 * r + 0.3575761 * g + 0.1804375 * b) / 0.95047,
+        0.2126729 * r + 0.7151522 * g + 0.0721750 * b,
+        (0.0193339 * r + 0.1191920 * g + 0.9503041 * b) / 1.08883,
+    };
+    double f[3];
+    for (int i = 0; i < 3; ++i) {
+        f[i] = xyz[i] > 216.0 / 24389.0 ? cbrt(xyz[i]) : (24389.0 / 27.0 * xyz[i] + 16.0) / 116.0;
+    }
+    out[0] = 116.0 * f[1] - 16.0;
+    out[1] = 500.0 * (f[0] - f[1]);
+    out[2] = 200.0 * (f[1] - f[2]);
+}
+
+static double hue(double b, double a) {
+    if (a == 0 && b == 0) return 0;
+    double h = atan2(b, a);
+    return h < 0 ? h + 2 * PI : h;
+}
+
+static double pow7(double x) {
+    double x2 = x * x;
+    return x2 * x2 * x2 * x;
+}
+
+// CIEDE2000, kL = kC = kH = 1 (Sharma, Wu and Dalal's formulation)
+static double delta_e2000(const double lab1[3], const double lab2[3]) {
+    const double pow25_7 = 6103515625.0;
+    double c1 = hypot(lab1[1], lab1[2]);
+    double c2 = hypot(lab2[1], lab2[2]);
+    double c_mean7 = pow7((c1 + c2) * 0.5);
+    double g = 0.5 * (1 - sqrt(c_mean7 / (c_mean7 + pow25_7)));
+    double a1 = (1 + g) * lab1[1];
+    double a2 = (1 + g) * lab2[1];
+    double c1p = hypot(a1, lab1[2]);
+    double c2p = hypot(a2, lab2[2]);
+    double h1p = hue(lab1[2], a1);
+    double h2p = hue(lab2[2], a2);
+    double dl = lab2[0] - lab1[0];
+    double dc = c2p - c1p;
+    double dh = 0;
+    double h_mean = h1p + h2p;
+    if (c1p * c2p != 0) {
+        dh = h2p - h1p;
+        if (dh > PI) dh -= 2 * PI;
+        else if (dh < -PI) dh += 2 * PI;
+        if (fabs(h1p - h2p) <= PI) h_mean = (h1p + h2p) * 0.5;
+        else if (h1p + h2p < 2 * PI) h_mean = (h1p + h2p + 2 * PI) * 0.5;
+        else h_mean = (h1p + h2p - 2 * PI) * 0.5;
+    }
+    double dhh = 2 * sqrt(c1p * c2p) * sin(dh * 0.5);
+    double l_mean = (lab1[0] + lab2[0]) * 0.5;
+    double cp_mean = (c1p + c2p) * 0.5;
+    double t = 1 - 0.17 * cos(h_mean - PI / 6) + 0.24 * cos(2 * h_mean) + 0.32 * cos(3 * h_mean + PI / 30) - 0.20 * cos(4 * h_mean - 63 * PI / 180);
+    double h_deg = h_mean * 180 / PI;
+    double d_theta = PI / 6 * exp(-((h_deg - 275) / 25) * ((h_deg - 275) / 25));
+    double cp_mean7 = pow7(cp_mean);
+    double rc = 2 * sqrt(cp_mean7 / (cp_mean7 + pow25_7));
+    double l50 = (l_mean - 50) * (l_mean - 50);
+    double sl = 1 + 0.015 * l50 / sqrt(20 + l50);
+    double sc = 1 + 0.045 * cp_mean;
+    double sh = 1 + 0.015 * cp_mean * t;
+    double rt = -sin(2 * d_theta) * rc;
+    double l = dl / sl, c = dc / sc, h = dhh / sh;
+    return sqrt(l * l + c * c + h * h + rt * c * h);
+}
+
+// blue, green (just noticeable), yellow, red
+static void heat_color(double delta_e, uint8_t *out) {
+    static const double stops[] = {0, 2.3, 5, 10};
+    static const uint8_t colors[][3] = {{0, 0, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0}};
+    int i = 0;
+    while (i < 2 && delta_e > stops[i + 1]) ++i;
+    double t = (delta_e - stops[i]) / (stops[i + 1] - stops[i]);
+    if (t > 1) t = 1;
+    for (int c = 0; c < 3; ++c) {
+        out[c] = colors[i][c] + (colors[i + 1][c] - colors[i][c]) * t + 0.5;
+    }
+}
+
+static void diff_row(struct job *job, struct accumulator *acc, int y) {
+    size_t offset = (size_t)y * job->width * 4;
+    const uint8_t *a = job->a + offset;
+    const uint8_t *b = job->b + offset;
+    uint8_t *heat = job->heat ? job->heat + (size_t)y * job->width * 3 : 0;
+    if (!memcmp(a, b, (size_t)job->width * 4)) {
+        for (int x = 0; heat && x < job->width; ++x) {
+            heat[x * 3] = heat[x * 3 + 1] = heat[x * 3 + 2] = (a[x * 4] + a[x * 4 + 1] + a[x * 4 + 2]) / 12;
+        }
+        return;
+    }
+    for (int x = 0; x < job->width; ++x, a += 4, b += 4) {
+        int max_code = 0;
+        for (int c = 0; c < 4; ++c) {
+            int d = abs(a[c] - b[c]);
+            double l = c < 3 ? fabs(job->linear[a[c]] - (double)job->linear[b[c]]) : d / 255.0;
+            acc->sum_srgb[c] += d;
+            acc->sum_linear[c] += l;
+            if (d > acc->max_srgb[c]) acc->max_srgb[c] = d;
+            if (l > acc->max_linear[c]) acc->max_linear[c] = l;
+            if (d > max_code) max_code = d;
+        }
+        if (!max_code) {
+            if (heat) heat[x * 3] = heat[x * 3 + 1] = heat[x * 3 + 2] = (a[0] + a[1] + a[2]) / 12;
+            continue;
+        }
+        ++acc->differing;
+        if (max_code > 1) ++acc->over_one_step;
+        double delta_e = 0;
+        if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2]) {
+            double lab_a[3], lab_b[3];
+            lab(job->linear, a, lab_a);
+            lab(job->linear, b, lab_b);
+            delta_e = delta_e2000(lab_a, lab_b);
+        }
+        acc->sum_delta_e += delta_e;
+        if (delta_e > acc->max_delta_e) {
+            acc->max_delta_e = delta_e;
+            acc->max_x = x;
+            acc->max_y = y;
+        }
+        if (heat) heat_color(delta_e, heat + x * 3);
+    }
+}
+
+static void diff_tile(void *arg, int worker, int tile) {
+    struct job *job = arg;
+    int row1 = (tile + 1) * TILE_POOL_ROWS < job->height ? (tile + 1) * TILE_POOL_ROWS : job->height;
+    for (int y = tile * TILE_POOL_ROWS; y < row1; ++y) {
+        diff_row(job, job->accumulators + worker, y);
+    }
+}
+
+int frame_diff(const uint8_t *a, const uint8_t *b, int width, int height, int threads, uint8_t *heat, struct frame_diff *out) {
+    struct job *job = calloc(1, sizeof (struct job));
+    if (!job) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    job->a = a;
+    job->b = b;
+    job->heat = heat;
+    job->width = width;
+    job->height = height;
+    for (int i = 0; i < 256; ++i) {
+        job->linear[i] = srgb_to_linear(i / 255.0f);
+    }
+    int workers = tile_pool_run(tile_pool_tiles(height), threads, diff_tile, job);
+    memset(out, 0, sizeof *out);
+    out->threads = workers;
+    struct accumulator total = {0};
+    for (int i = 0; i < workers; ++i) {
+        const struct accumulator *acc = job->accumulators + i;
+        for (int c = 0; c < 4; ++c) {
+            total.sum_srgb[c] += acc->sum_srgb[c];
+            total.sum_linear[c] += acc->sum_linear[c];
+            if (acc->max_srgb[c] > total.max_srgb[c]) total.max_srgb[c] = acc->max_srgb[c];
+            if (acc->max_linear[c] > total.max_linear[c]) total.max_linear[c] = acc->max_linear[c];
+        }
+        total.differing += acc->differing;
+        total.over_one_step += acc->over_one_step;
+        total.sum_delta_e += acc->sum_delta_e;
+        // tiles are taken in order, the lowest row wins a tie
+        if (acc->max_delta_e > total.max_delta_e ||
+            (acc->max_delta_e == total.max_delta_e && acc->max_delta_e > 0 && acc->max_y < total.max_y)) {
+            total.max_delta_e = acc->max_delta_e;
+            total.max_x = acc->max_x;
+            total.max_y = acc->max_y;
+        }
+    }
+    double pixels = (double)width * height;
+    for (int c = 0; c < 4; ++c) {
+        out->max_srgb[c] = total.max_srgb[c];
+        out->max_linear[c] = total.max_linear[c];
+        out->mean_srgb[c] = pixels > 0 ? total.sum_srgb[c] / pixels : 0;
+        out->mean_linear[c] = pixels > 0 ? total.sum_linear[c] / pixels : 0;
+    }
+    out->differing = total.differing;
+    out->over_one_step = total.over_one_step;
+    out->max_delta_e = total.max_delta_e;
+    out->mean_delta_e = pixels > 0 ? total.sum_delta_e / pixels : 0;
+    out->max_x = total.max_x;
+    out->max_y = total.max_y;
+    free(job);
+    return 0;
+}
+
+int frame_diff_write_ppm(const char *path, const uint8_t *heat, int width, int height) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    int failed = fprintf(file, "P6\n%d %d\n255\n", width, height) < 0;
+    for (int y = height - 1; y >= 0 && !failed; --y) {
+        failed = fwrite(heat + (size_t)y * width * 3, (size_t)width * 3, 1, file) != 1;
+    }
+    if (fclose(file)) failed = 1;
+    if (failed) fprintf(stderr, "cannot write %s\n", path);
+    return failed;
+}
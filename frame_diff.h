@@ -0,0 +1,39 @@
+//  MIT license
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <stdint.h>
+
+// More than pass/fail for two rgba8 sRGB frames (e.g. a readback and its
+// reference): per channel max and mean absolute error as sRGB codes and
+// in linear, CIEDE2000 of the rgb, and the pixels more than one sRGB
+// step off. Rows are split in tiles of 16 scanlines spread across
+// threads, identical rows are skipped with a memcmp and dE is only
+// computed for differing pixels, so mostly equal frames are cheap.
+struct frame_diff {
+    // r, g, b, a; linear is the decoded value for rgb, code / 255 for a
+    int max_srgb[4];
+    double mean_srgb[4];
+    double max_linear[4];
+    double mean_linear[4];
+    // pixels not equal, and with a channel more than one code off
+    long differing;
+    long over_one_step;
+    // CIEDE2000 (D65, rgb only), the mean is over all pixels
+    double max_delta_e;
+    double mean_delta_e;
+    // first pixel of max_delta_e
+    int max_x, max_y;
+    int threads;
+};
+
+// threads: 0 for one per online cpu
+// heat: 0, or width * height * 3 bytes for an rgb8 heat map of dE (same
+// row order as the frames): equal pixels are the frame darkened, others
+// go blue (dE 0), green (2.3, just noticeable), yellow (5) to red (10+)
+int frame_diff(const uint8_t *a, const uint8_t *b, int width, int height, int threads, uint8_t *heat, struct frame_diff *out);
+// binary PPM of a heat map of glReadPixels order frames (bottom row
+// first), written top row first
+int frame_diff_write_ppm(const char *path, const uint8_t *heat, int width, int height);
+
+#endif
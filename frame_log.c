@@ -0,0 +1,97 @@
+//  MIT license
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "frame_log.h"
+
+// records start on page boundaries, so a tool can map a single one
+#define PAGE_SIZE_BYTES 4096
+
+_Static_assert(sizeof (struct frame_log_file_header) <= PAGE_SIZE_BYTES, "file header fits its page");
+_Static_assert(sizeof (struct frame_log_record) % 16 == 0, "pixels are 16 byte aligned");
+
+uint64_t frame_log_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+int frame_log_create(struct frame_log *log, const char *path, uint64_t records, uint64_t max_pixel_bytes) {
+    log->fd = -1;
+    log->map = 0;
+    log->header = 0;
+    log->dropped = 0;
+    uint64_t record_size = (sizeof (struct frame_log_record) + max_pixel_bytes + PAGE_SIZE_BYTES - 1) / PAGE_SIZE_BYTES * PAGE_SIZE_BYTES;
+    log->map_size = PAGE_SIZE_BYTES + records * record_size;
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (log->fd < 0) {
+        fprintf(stderr, "frame_log: cannot create %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    // the blocks are allocated now, not by the page faults of the run
+    int error = posix_fallocate(log->fd, 0, log->map_size);
+    if (error) {
+        fprintf(stderr, "frame_log: cannot allocate %zu bytes for %s: %s\n", log->map_size, path, strerror(error));
+        frame_log_close(log);
+        return 1;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void *map = mmap(0, log->map_size, PROT_READ | PROT_WRITE, flags, log->fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "frame_log: cannot map %s: %s\n", path, strerror(errno));
+        frame_log_close(log);
+        return 1;
+    }
+    log->map = map;
+    log->header = map;
+    memcpy(log->header->magic, FRAME_LOG_MAGIC, sizeof log->header->magic);
+    log->header->version = FRAME_LOG_VERSION;
+    log->header->header_size = PAGE_SIZE_BYTES;
+    log->header->record_size = record_size;
+    log->header->records = records;
+    log->header->count = 0;
+    log->header->max_pixel_bytes = record_size - sizeof (struct frame_log_record);
+    return 0;
+}
+
+struct frame_log_record *frame_log_next(struct frame_log *log, uint32_t pixel_bytes) {
+    struct frame_log_file_header *header = log->header;
+    if (header->count == header->records || pixel_bytes > header->max_pixel_bytes) {
+        ++log->dropped;
+        return 0;
+    }
+    struct frame_log_record *record = FRAME_LOG_RECORD(header, header->count);
+    memset(record, 0, sizeof *record);
+    record->index = header->count;
+    record->pixel_bytes = pixel_bytes;
+    return record;
+}
+
+void frame_log_commit(struct frame_log *log, struct frame_log_record *record) {
+    record->readback_ns = frame_log_now_ns();
+    log->header->count = record->index + 1;
+}
+
+int frame_log_close(struct frame_log *log) {
+    int failed = 0;
+    if (log->map) {
+        // the only sync: the run itself only wrote to memory
+        if (msync(log->map, log->map_size, MS_SYNC)) {
+            fprintf(stderr, "frame_log: msync failed: %s\n", strerror(errno));
+            failed = 1;
+        }
+        munmap(log->map, log->map_size);
+    }
+    if (log->fd >= 0 && close(log->fd)) failed = 1;
+    log->fd = -1;
+    log->map = 0;
+    log->header = 0;
+    return failed;
+}
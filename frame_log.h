@@ -0,0 +1,70 @@
+//  MIT license
+#ifndef FRAME_LOG_H
+#define FRAME_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Raw frames of a long run in one preallocated, memory mapped file of
+// fixed size records, for offline tools that map it too: no parsing, a
+// record is at header_size + i * record_size. glReadPixels reads straight
+// into the mapping, so logging a frame costs no copy and no syscall; the
+// file is synced once, at close. The log keeps the first records frames,
+// later ones are counted as dropped.
+// All fields are host endian (little endian on x86 and arm).
+#define FRAME_LOG_MAGIC "GLSRGBFL"
+#define FRAME_LOG_VERSION 1
+
+struct frame_log_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t record_size;
+    uint64_t records;
+    // committed records, updated in place
+    uint64_t count;
+    uint64_t max_pixel_bytes;
+};
+
+struct frame_log_record {
+    // sequence number, from 0
+    uint64_t index;
+    // CLOCK_MONOTONIC ns: frame submitted, read back (committed)
+    uint64_t render_ns;
+    uint64_t readback_ns;
+    uint32_t case_id;
+    // glReadPixels format and type, e.g. GL_RGBA, GL_UNSIGNED_BYTE
+    uint32_t format;
+    uint32_t type;
+    int32_t width, height;
+    uint32_t pixel_bytes;
+    char case_name[64];
+    // pixels follow, glReadPixels order (bottom row first)
+};
+
+struct frame_log {
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    struct frame_log_file_header *header;
+    unsigned long dropped;
+};
+
+// the record at this offset in a mapping of the file
+#define FRAME_LOG_RECORD(header, i) \
+    ((struct frame_log_record *)((uint8_t *)(header) + (header)->header_size + (i) * (header)->record_size))
+#define FRAME_LOG_PIXELS(record) ((uint8_t *)(record) + sizeof (struct frame_log_record))
+
+// creates (or replaces) path with room for records of max_pixel_bytes,
+// allocated on disk and mapped up front
+int frame_log_create(struct frame_log *log, const char *path, uint64_t records, uint64_t max_pixel_bytes);
+// the next record, to fill in and read pixels into, 0 (and a drop
+// counted) if the log is full or pixel_bytes does not fit
+struct frame_log_record *frame_log_next(struct frame_log *log, uint32_t pixel_bytes);
+// the record returned by frame_log_next is complete
+void frame_log_commit(struct frame_log *log, struct frame_log_record *record);
+uint64_t frame_log_now_ns(void);
+// msync, unmap and close
+int frame_log_close(struct frame_log *log);
+
+#endif
@@ -0,0 +1,309 @@
+//  MIT license
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "frame_sink.h"
+#include "srgb.h"
+
+static const char *const format_names[] = {"ppm", "png", "exr"};
+
+const char *frame_sink_format_name(enum frame_sink_format format) {
+    return format >= FRAME_SINK_PPM && format <= FRAME_SINK_EXR ? format_names[format] : "unknown";
+}
+
+int frame_sink_format_by_name(const char *name) {
+    for (int i = 0; i <= FRAME_SINK_EXR; ++i) {
+        if (!strcmp(format_names[i], name)) return i;
+    }
+    return -1;
+}
+
+// row y counted from the top, as rgba8 sRGB
+static void rgba8_row(const struct frame_sink_frame *frame, int y, uint8_t *out) {
+    size_t row = (size_t)(frame->height - 1 - y) * frame->width * 4;
+    if (frame->type == FRAME_SINK_RGBA8) {
+        memcpy(out, (const uint8_t *)frame->pixels + row, (size_t)frame->width * 4);
+        return;
+    }
+    const float *in = (const float *)frame->pixels + row;
+    for (int i = 0; i < frame->width * 4; ++i) {
+        float value = in[i] > 0.0f ? (in[i] < 1.0f ? in[i] : 1.0f) : 0.0f;
+        out[i] = (i % 4 == 3 ? value : linear_to_srgb(value)) * 255.0f + 0.5f;
+    }
+}
+
+// row y counted from the top, as linear float rgba
+static void float_row(const struct frame_sink_frame *frame, const float decode[256], int y, float *out) {
+    size_t row = (size_t)(frame->height - 1 - y) * frame->width * 4;
+    if (frame->type == FRAME_SINK_RGBA32F) {
+        memcpy(out, (const float *)frame->pixels + row, (size_t)frame->width * 4 * sizeof (float));
+        return;
+    }
+    const uint8_t *in = (const uint8_t *)frame->pixels + row;
+    for (int i = 0; i < frame->width * 4; ++i) {
+        out[i] = i % 4 == 3 ? in[i] / 255.0f : decode[in[i]];
+    }
+}
+
+static int write_ppm(FILE *file, const struct frame_sink_frame *frame) {
+    uint8_t *rgba = malloc((size_t)frame->width * 4);
+    uint8_t *rgb = malloc((size_t)frame->width * 3);
+    int failed = !rgba || !rgb || fprintf(file, "P6\n%d %d\n255\n", frame->width, frame->height) < 0;
+    for (int y = 0; y < frame->height && !failed; ++y) {
+        rgba8_row(frame, y, rgba);
+        for (int x = 0; x < frame->width; ++x) {
+            memcpy(rgb + x * 3, rgba + x * 4, 3);
+        }
+        failed = fwrite(rgb, (size_t)frame->width * 3, 1, file) != 1;
+    }
+    free(rgba);
+    free(rgb);
+    return failed;
+}
+
+static void put_be32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static int write_chunk(FILE *file, const char *type, const uint8_t *data, uint32_t size) {
+    uint8_t header[8];
+    put_be32(header, size);
+    memcpy(header + 4, type, 4);
+    // crc32 of a null buffer is 0, not the running crc
+    uLong running = crc32(crc32(0, 0, 0), header + 4, 4);
+    uint8_t crc[4];
+    put_be32(crc, size ? crc32(running, data, size) : running);
+    return fwrite(header, 8, 1, file) != 1 || (size && fwrite(data, size, 1, file) != 1) || fwrite(crc, 4, 1, file) != 1;
+}
+
+// rgba8, no filter, one IDAT: the frames are flat, deflate does the work
+static int write_png(FILE *file, const struct frame_sink_frame *frame) {
+    size_t row_bytes = 1 + (size_t)frame->width * 4;
+    uLong raw_size = row_bytes * frame->height;
+    uLongf compressed_size = compressBound(raw_size);
+    uint8_t *raw = malloc(raw_size);
+    uint8_t *compressed = malloc(compressed_size);
+    int failed = !raw || !compressed;
+    for (int y = 0; y < frame->height && !failed; ++y) {
+        raw[y * row_bytes] = 0;
+        rgba8_row(frame, y, raw + y * row_bytes + 1);
+    }
+    if (!failed) failed = compress2(compressed, &compressed_size, raw, raw_size, 1) != Z_OK;
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    // size, 8 bits per channel, rgba, deflate, no filter method, no interlace
+    uint8_t ihdr[13] = {0, 0, 0, 0, 0, 0, 0, 0, 8, 6, 0, 0, 0};
+    put_be32(ihdr, frame->width);
+    put_be32(ihdr + 4, frame->height);
+    if (!failed) {
+        failed = fwrite(signature, 8, 1, file) != 1 || write_chunk(file, "IHDR", ihdr, sizeof ihdr) ||
+            write_chunk(file, "IDAT", compressed, compressed_size) || write_chunk(file, "IEND", 0, 0);
+    }
+    free(raw);
+    free(compressed);
+    return failed;
+}
+
+static void put_attribute(FILE *file, const char *name, const char *type, const void *value, int32_t size) {
+    fwrite(name, strlen(name) + 1, 1, file);
+    fwrite(type, strlen(type) + 1, 1, file);
+    fwrite(&size, 4, 1, file);
+    fwrite(value, size, 1, file);
+}
+
+// scanline OpenEXR, no compression, float A, B, G, R (channels sorted
+// by name), one line per block; little endian, as the format
+static int write_exr(FILE *file, const struct frame_sink_frame *frame) {
+    static const uint8_t magic[8] = {0x76, 0x2f, 0x31, 0x01, 2, 0, 0, 0};
+    fwrite(magic, 8, 1, file);
+    uint8_t channels[4 * 18 + 1];
+    const char names[] = "ABGR";
+    for (int c = 0; c < 4; ++c) {
+        // name, pixel type 2 (float), pLinear and reserved, x and y sampling
+        uint8_t *channel = channels + c * 18;
+        int32_t pixel_type = 2;
+        int32_t sampling[2] = {1, 1};
+        channel[0] = names[c];
+        channel[1] = 0;
+        memcpy(channel + 2, &pixel_type, 4);
+        memset(channel + 6, 0, 4);
+        memcpy(channel + 10, sampling, 8);
+    }
+    channels[sizeof channels - 1] = 0;
+    put_attribute(file, "channels", "chlist", channels, sizeof channels);
+    uint8_t compression = 0;
+    put_attribute(file, "compression", "compression", &compression, 1);
+    int32_t window[4] = {0, 0, frame->width - 1, frame->height - 1};
+    put_attribute(file, "dataWindow", "box2i", window, sizeof window);
+    put_attribute(file, "displayWindow", "box2i", window, sizeof window);
+    uint8_t line_order = 0;
+    put_attribute(file, "lineOrder", "lineOrder", &line_order, 1);
+    float one = 1.0f;
+    put_attribute(file, "pixelAspectRatio", "float", &one, 4);
+    float center[2] = {0, 0};
+    put_attribute(file, "screenWindowCenter", "v2f", center, sizeof center);
+    put_attribute(file, "screenWindowWidth", "float", &one, 4);
+    fputc(0, file);
+    // offsets of the lines, which follow the table
+    int32_t line_bytes = frame->width * 4 * (int32_t)sizeof (float);
+    uint64_t offset = ftell(file) + (uint64_t)frame->height * 8;
+    for (int y = 0; y < frame->height; ++y) {
+        fwrite(&offset, 8, 1, file);
+        offset += 8 + line_bytes;
+    }
+    float decode[256];
+    for (int i = 0; i < 256; ++i) {
+        decode[i] = srgb_to_linear(i / 255.0f);
+    }
+    float *rgba = malloc(line_bytes);
+    float *planes = malloc(line_bytes);
+    int failed = !rgba || !planes || ferror(file);
+    for (int y = 0; y < frame->height && !failed; ++y) {
+        float_row(frame, decode, y, rgba);
+        for (int c = 0; c < 4; ++c) {
+            // A, B, G, R
+            int channel = 3 - c;
+            for (int x = 0; x < frame->width; ++x) {
+                planes[c * frame->width + x] = rgba[x * 4 + channel];
+            }
+        }
+        int32_t line[2] = {y, line_bytes};
+        failed = fwrite(line, 8, 1, file) != 1 || fwrite(planes, line_bytes, 1, file) != 1;
+    }
+    free(rgba);
+    free(planes);
+    return failed;
+}
+
+static int write_frame(struct frame_sink *sink, const struct frame_sink_frame *frame) {
+    char path[1024];
+    snprintf(path, sizeof path, "%s/%s.%s", sink->dir, frame->name, frame_sink_format_name(sink->format));
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "frame_sink: cannot write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    int failed = sink->format == FRAME_SINK_PPM ? write_ppm(file, frame) : sink->format == FRAME_SINK_PNG ? write_png(file, frame)
+        : write_exr(file, frame);
+    if (fclose(file)) failed = 1;
+    if (failed) fprintf(stderr, "frame_sink: failed to write %s\n", path);
+    return failed;
+}
+
+static void *encoder(void *arg) {
+    struct frame_sink *sink = arg;
+    pthread_mutex_lock(&sink->lock);
+    for (;;) {
+        while (!sink->queue_count && !sink->stopping) {
+            pthread_cond_wait(&sink->wake, &sink->lock);
+        }
+        // stopping, and everything queued is written
+        if (!sink->queue_count) break;
+        int slot = sink->queue[sink->queue_head];
+        sink->queue_head = (sink->queue_head + 1) % FRAME_SINK_MAX_SLOTS;
+        --sink->queue_count;
+        sink->busy = 1;
+        // the render thread only ever waits for this lock, not for a write
+        pthread_mutex_unlock(&sink->lock);
+        int failed = write_frame(sink, &sink->slots[slot]);
+        pthread_mutex_lock(&sink->lock);
+        sink->busy = 0;
+        if (failed) {
+            ++sink->failed;
+        } else {
+            ++sink->written;
+        }
+        sink->free[sink->free_count++] = slot;
+        if (!sink->queue_count) pthread_cond_broadcast(&sink->idle);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return 0;
+}
+
+int frame_sink_setup(struct frame_sink *sink, const char *dir, enum frame_sink_format format, int slots, size_t slot_bytes) {
+    memset(sink, 0, sizeof *sink);
+    if (slots < 1) slots = 1;
+    if (slots > FRAME_SINK_MAX_SLOTS) slots = FRAME_SINK_MAX_SLOTS;
+    if (mkdir(dir, 0777) && errno != EEXIST) {
+        fprintf(stderr, "frame_sink: cannot create %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+    sink->dir = strdup(dir);
+    sink->format = format;
+    sink->slot_bytes = slot_bytes;
+    for (int i = 0; i < slots; ++i) {
+        sink->slots[i].pixels = malloc(slot_bytes);
+        if (!sink->slots[i].pixels || !sink->dir) {
+            fprintf(stderr, "out of mem\n");
+            frame_sink_teardown(sink);
+            return 1;
+        }
+        ++sink->slots_count;
+        sink->free[sink->free_count++] = i;
+    }
+    pthread_mutex_init(&sink->lock, 0);
+    pthread_cond_init(&sink->wake, 0);
+    pthread_cond_init(&sink->idle, 0);
+    sink->initialized = 1;
+    if (pthread_create(&sink->thread, 0, encoder, sink)) {
+        fprintf(stderr, "frame_sink: no encoder thread\n");
+        frame_sink_teardown(sink);
+        return 1;
+    }
+    sink->running = 1;
+    return 0;
+}
+
+struct frame_sink_frame *frame_sink_acquire(struct frame_sink *sink, size_t bytes) {
+    struct frame_sink_frame *frame = 0;
+    pthread_mutex_lock(&sink->lock);
+    if (bytes <= sink->slot_bytes && sink->free_count) frame = &sink->slots[sink->free[--sink->free_count]];
+    pthread_mutex_unlock(&sink->lock);
+    if (!frame) ++sink->dropped;
+    return frame;
+}
+
+void frame_sink_submit(struct frame_sink *sink, struct frame_sink_frame *frame) {
+    pthread_mutex_lock(&sink->lock);
+    sink->queue[(sink->queue_head + sink->queue_count) % FRAME_SINK_MAX_SLOTS] = frame - sink->slots;
+    ++sink->queue_count;
+    pthread_cond_signal(&sink->wake);
+    pthread_mutex_unlock(&sink->lock);
+}
+
+void frame_sink_flush(struct frame_sink *sink) {
+    pthread_mutex_lock(&sink->lock);
+    while (sink->queue_count || sink->busy) {
+        pthread_cond_wait(&sink->idle, &sink->lock);
+    }
+    pthread_mutex_unlock(&sink->lock);
+}
+
+void frame_sink_teardown(struct frame_sink *sink) {
+    if (sink->running) {
+        pthread_mutex_lock(&sink->lock);
+        sink->stopping = 1;
+        pthread_cond_signal(&sink->wake);
+        pthread_mutex_unlock(&sink->lock);
+        pthread_join(sink->thread, 0);
+        sink->running = 0;
+    }
+    if (sink->initialized) {
+        pthread_mutex_destroy(&sink->lock);
+        pthread_cond_destroy(&sink->wake);
+        pthread_cond_destroy(&sink->idle);
+        sink->initialized = 0;
+    }
+    for (int i = 0; i < sink->slots_count; ++i) {
+        free(sink->slots[i].pixels);
+        sink->slots[i].pixels = 0;
+    }
+    sink->slots_count = 0;
+    free(sink->dir);
+    sink->dir = 0;
+}
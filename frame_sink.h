@@ -0,0 +1,86 @@
+//  MIT license
+#ifndef FRAME_SINK_H
+#define FRAME_SINK_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Writes frames to files on a background thread, so dumping every frame
+// of a run costs the render thread a readback and no encoding. Memory is
+// bounded: a fixed number of slots of a fixed size, allocated at setup
+// (and the encoder's scratch for one frame).
+// The render thread reads pixels into a free slot and queues it; when
+// every slot is still queued or being written, frame_sink_acquire
+// returns 0 at once and the frame is dropped (and counted) instead of
+// waiting for the encoder.
+// Files are <dir>/<name>.ppm (rgb8), .png (rgba8, zlib level 1) or .exr
+// (uncompressed 32-bit float rgba, linear). rgba8 frames are sRGB
+// encoded, rgba32f frames linear; each is converted as the file needs.
+#define FRAME_SINK_MAX_SLOTS 16
+
+enum frame_sink_format {
+    FRAME_SINK_PPM,
+    FRAME_SINK_PNG,
+    FRAME_SINK_EXR,
+};
+
+enum frame_sink_pixels {
+    // GL_RGBA, GL_UNSIGNED_BYTE
+    FRAME_SINK_RGBA8,
+    // GL_RGBA, GL_FLOAT
+    FRAME_SINK_RGBA32F,
+};
+
+struct frame_sink_frame {
+    // slot_bytes of storage, rows in glReadPixels order (bottom first)
+    void *pixels;
+    enum frame_sink_pixels type;
+    int width, height;
+    char name[64];
+};
+
+struct frame_sink {
+    char *dir;
+    enum frame_sink_format format;
+    size_t slot_bytes;
+    int slots_count;
+    struct frame_sink_frame slots[FRAME_SINK_MAX_SLOTS];
+    // slots that are free, and queued in order for the encoder
+    int free[FRAME_SINK_MAX_SLOTS];
+    int free_count;
+    int queue[FRAME_SINK_MAX_SLOTS];
+    int queue_head, queue_count;
+    // a frame is being written
+    int busy;
+    int stopping;
+    // lock and condition variables made, encoder thread started
+    int initialized;
+    int running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    // written by the encoder thread (under lock)
+    unsigned long written;
+    unsigned long failed;
+    // render thread only
+    unsigned long dropped;
+};
+
+// "ppm", "png", "exr"; by_name returns -1 for an unknown name
+const char *frame_sink_format_name(enum frame_sink_format format);
+int frame_sink_format_by_name(const char *name);
+// slots of slot_bytes each (at most FRAME_SINK_MAX_SLOTS), creates dir
+int frame_sink_setup(struct frame_sink *sink, const char *dir, enum frame_sink_format format, int slots, size_t slot_bytes);
+// a free slot, 0 (and a drop counted) if none is free or bytes does not
+// fit a slot; never waits
+struct frame_sink_frame *frame_sink_acquire(struct frame_sink *sink, size_t bytes);
+// queues an acquired slot, pixels, type, size and name filled in
+void frame_sink_submit(struct frame_sink *sink, struct frame_sink_frame *frame);
+// waits until every queued frame is written
+void frame_sink_flush(struct frame_sink *sink);
+// flushes, stops the encoder and frees the slots
+void frame_sink_teardown(struct frame_sink *sink);
+
+#endif
@@ -0,0 +1,47 @@
+//  MIT license
+#include <stdio.h>
+#include "fullscreen.h"
+#include "gl_compile.h"
+#include "gl_error.h"
+#include "gl_state.h"
+
+static const char *const vsh_body =
+    "void main() {\n"
+    "    vec2 p = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);\n"
+    "    gl_Position = vec4(p, 0.0, 1.0);\n"
+    "}\n";
+
+int fullscreen_setup(struct fullscreen *fullscreen, enum gl_api api, const char *fsh_body) {
+    fullscreen->program = 0;
+    fullscreen->vertex_array = 0;
+    char vsh[1024], fsh[4096];
+    const char *version = api == GL_API_OPENGL ? "#version 330 core\n" : "#version 300 es\n";
+    snprintf(vsh, sizeof vsh, "%s%s", version, vsh_body);
+    if (snprintf(fsh, sizeof fsh, "%s%s", version, fsh_body) >= (int)sizeof fsh) {
+        fprintf(stderr, "fullscreen_setup: fragment shader too long\n");
+        return 1;
+    }
+    GLuint vert_shader = 0;
+    GLuint frag_shader = 0;
+    if (gl_compile_program_start(vsh, fsh, &fullscreen->program, &vert_shader, &frag_shader) ||
+        gl_compile_program_finish(fullscreen->program, vert_shader, frag_shader)) {
+        return 1;
+    }
+    // GL core draws nothing without a vertex array, even with no attributes
+    glGenVertexArrays(1, &fullscreen->vertex_array);
+    if (CHECK_GL_STAGE("fullscreen_setup")) return 1;
+    return 0;
+}
+
+void fullscreen_draw(struct fullscreen *fullscreen) {
+    gl_state_use_program(fullscreen->program);
+    gl_state_bind_vertex_array(fullscreen->vertex_array);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void fullscreen_teardown(struct fullscreen *fullscreen) {
+    if (fullscreen->program) gl_state_delete_program(fullscreen->program);
+    if (fullscreen->vertex_array) gl_state_delete_vertex_arrays(1, &fullscreen->vertex_array);
+    fullscreen->program = 0;
+    fullscreen->vertex_array = 0;
+}
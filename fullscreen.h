@@ -0,0 +1,22 @@
+//  MIT license
+#ifndef FULLSCREEN_H
+#define FULLSCREEN_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+
+// A program drawing one triangle over the whole viewport, placed by
+// gl_VertexID with no vertex attributes: the fragment shader does the
+// work. GLSL 330 core for GL, 300 es for GL ES.
+struct fullscreen {
+    GLuint program;
+    GLuint vertex_array;
+};
+
+// fsh_body: the fragment shader without its #version line
+int fullscreen_setup(struct fullscreen *fullscreen, enum gl_api api, const char *fsh_body);
+// with the program in use and the textures and target bound
+void fullscreen_draw(struct fullscreen *fullscreen);
+void fullscreen_teardown(struct fullscreen *fullscreen);
+
+#endif
@@ -0,0 +1,16 @@
+#!/usr/bin/env sh
+# Lists the GL entry points the given sources actually call, as
+# GL_PROC(name) lines for gl_load.c, so only those are resolved at startup.
+# usage: gen_gl_procs.sh <glad include dir> <glad glx include dir> <sources...> > gl_procs.h
+# CC (default gcc) preprocesses, with CFLAGS
+glad_include=$1
+glad_glx_include=$2
+shift 2
+echo "// generated by gen_gl_procs.sh, do not edit"
+for src in "$@"; do
+    # keep only the lines that come from the source itself (not from
+    # headers), glad turns every GL call there into glad_<name>
+    ${CC:-gcc} -E -I ${glad_include} -I ${glad_glx_include} ${CFLAGS} "${src}" | awk -v src="${src}" '
+        /^# [0-9]+ "/ { split($0, marker, "\""); keep = (marker[2] == src); next }
+        keep { print }'
+done | grep -o 'glad_gl[A-Za-z0-9_]*' | grep -v '^glad_glX[A-Z]' | sed 's/^glad_\(.*\)$/GL_PROC(\1)/' | sort -u
@@ -116,3 +116,23 @@ int gl_compile_program_finish(GLuint program, GLuint vert_shader, GLuint frag_sh
     return 0;
 }
 
+int gl_compile_compute_program(const char * const csh_src, GLuint *program) {
+    GLuint shader = 0;
+    *program = 0;
+    if (_compile_shader(&shader, GL_COMPUTE_SHADER, csh_src)) {
+        fprintf(stderr, "Failed to compile compute shader:\n%s\n", csh_src);
+        return 1;
+    }
+    fprintf(stderr, "compiled compute shader: \n%s\n", csh_src);
+    *program = glCreateProgram();
+    glAttachShader(*program, shader);
+    if (CHECK_GL()) return 1;
+    if (_link_program(*program)) {
+        fprintf(stderr, "Failed to link program: %d\n", *program);
+        glDeleteShader(shader);
+        return 1;
+    }
+    glDetachShader(*program, shader);
+    glDeleteShader(shader);
+    return 0;
+}
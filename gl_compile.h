@@ -7,6 +7,8 @@
 
 int gl_compile_program_start(const char * const vsh_src, const char * const fsh_src,  GLuint *program, GLuint *vert_shader, GLuint *frag_shader);
 int gl_compile_program_finish(GLuint program, GLuint vert_shader, GLuint frag_shader);
+// compiles and links a program of one compute shader
+int gl_compile_compute_program(const char * const csh_src, GLuint *program);
 
 #endif
 
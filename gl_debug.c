@@ -0,0 +1,189 @@
+//  MIT license
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "gl_debug.h"
+#include "gl_error.h"
+#include "gl_ext.h"
+
+#define GL_DEBUG_TEXT_SIZE 256
+// must be a power of two
+#define GL_DEBUG_RING_SIZE 256
+
+struct gl_debug_msg {
+    GLenum source;
+    GLenum type;
+    GLenum severity;
+    GLuint id;
+    char text[GL_DEBUG_TEXT_SIZE];
+};
+
+// bounded multi-producer (the driver may call back from its own threads
+// when output is asynchronous) single-consumer ring, each slot carries a
+// sequence number telling whether it is free for the producer at that
+// position or filled for the consumer.
+struct gl_debug_slot {
+    atomic_size_t seq;
+    struct gl_debug_msg msg;
+};
+
+static struct gl_debug_slot ring[GL_DEBUG_RING_SIZE];
+static atomic_size_t ring_head;
+static size_t ring_tail;
+static atomic_uint ring_dropped;
+static atomic_int logger_running;
+static pthread_t logger_thread;
+
+static int ring_push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message) {
+    size_t pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    struct gl_debug_slot *slot;
+    for (;;) {
+        slot = &ring[pos & (GL_DEBUG_RING_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring_head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // full, the logger is behind: drop rather than block the GL
+            return 1;
+        } else {
+            pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        }
+    }
+    slot->msg.source = source;
+    slot->msg.type = type;
+    slot->msg.id = id;
+    slot->msg.severity = severity;
+    size_t n = length < 0 ? strlen(message) : (size_t)length;
+    if (n > GL_DEBUG_TEXT_SIZE - 1) n = GL_DEBUG_TEXT_SIZE - 1;
+    memcpy(slot->msg.text, message, n);
+    slot->msg.text[n] = 0;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+static int ring_pop(struct gl_debug_msg *out) {
+    struct gl_debug_slot *slot = &ring[ring_tail & (GL_DEBUG_RING_SIZE - 1)];
+    size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq != ring_tail + 1) return 1;
+    *out = slot->msg;
+    atomic_store_explicit(&slot->seq, ring_tail + GL_DEBUG_RING_SIZE, memory_order_release);
+    ++ring_tail;
+    return 0;
+}
+
+static const char *source_str(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API: return "api";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window-system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader-compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third-party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+static const char *type_str(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined-behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        default: return "other";
+    }
+}
+
+static const char *severity_str(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+        case GL_DEBUG_SEVERITY_NOTIFICATION: return "notification";
+        default: return "unknown";
+    }
+}
+
+static int drain(void) {
+    struct gl_debug_msg msg;
+    int count = 0;
+    while (!ring_pop(&msg)) {
+        fprintf(stderr, "GL debug [%s %s %s] 0x%x: %s\n", source_str(msg.source), type_str(msg.type), severity_str(msg.severity), msg.id, msg.text);
+        ++count;
+    }
+    unsigned dropped = atomic_exchange(&ring_dropped, 0);
+    if (dropped) {
+        fprintf(stderr, "GL debug: dropped %u messages (ring full)\n", dropped);
+    }
+    return count;
+}
+
+static void *logger_main(void *arg) {
+    (void)arg;
+    struct timespec idle = {0, 2 * 1000 * 1000};
+    while (atomic_load(&logger_running)) {
+        if (!drain()) nanosleep(&idle, 0);
+    }
+    return 0;
+}
+
+static void APIENTRY gl_debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *user_param) {
+    (void)user_param;
+    if (ring_push(source, type, id, severity, length, message)) {
+        atomic_fetch_add(&ring_dropped, 1);
+    }
+}
+
+static int has_khr_debug(enum gl_api api) {
+    // core since GL 4.3, GL ES has it as an extension only
+    if (api == GL_API_OPENGL && (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3))) return 1;
+    return glsrgb_has_extension("GL_KHR_debug");
+}
+
+int gl_debug_setup(enum gl_api api, int synchronous) {
+    if (!has_khr_debug(api) || !glDebugMessageCallback) {
+        fprintf(stderr, "GL_KHR_debug not supported, no debug output\n");
+        return 1;
+    }
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (CHECK_GL() || !(flags & GL_CONTEXT_FLAG_DEBUG_BIT)) {
+        fprintf(stderr, "not a debug context, no debug output\n");
+        return 1;
+    }
+    // one logger serves every context made current on this thread
+    if (!atomic_load(&logger_running)) {
+        for (size_t i = 0; i < GL_DEBUG_RING_SIZE; ++i) {
+            atomic_init(&ring[i].seq, i);
+        }
+        atomic_init(&ring_head, 0);
+        ring_tail = 0;
+        atomic_init(&ring_dropped, 0);
+        atomic_init(&logger_running, 1);
+        if (pthread_create(&logger_thread, 0, logger_main, 0)) {
+            fprintf(stderr, "failed to start GL debug logger thread\n");
+            atomic_store(&logger_running, 0);
+            return 1;
+        }
+    }
+    glDebugMessageCallback(gl_debug_callback, 0);
+    glEnable(GL_DEBUG_OUTPUT);
+    if (synchronous) {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    } else {
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    if (CHECK_GL()) return 1;
+    fprintf(stderr, "GL debug output enabled (%s)\n", synchronous ? "synchronous" : "asynchronous");
+    return 0;
+}
+
+void gl_debug_teardown(void) {
+    if (!atomic_load(&logger_running)) return;
+    atomic_store(&logger_running, 0);
+    pthread_join(logger_thread, 0);
+    drain();
+}
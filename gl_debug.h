@@ -0,0 +1,17 @@
+//  MIT license
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+
+// Installs a GL_KHR_debug message callback on the current context.
+// The callback only copies each message into a lock-free ring, a logger
+// thread drains the ring and prints to stderr, so reporting never stalls
+// the render thread. Output is asynchronous unless synchronous is set.
+// Returns 1 if the context is not a debug context or lacks KHR_debug.
+int gl_debug_setup(enum gl_api api, int synchronous);
+// Stops the logger thread, printing whatever is still in the ring.
+void gl_debug_teardown(void);
+
+#endif
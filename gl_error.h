@@ -3,7 +3,30 @@
 #ifndef GL_ERROR_H
 #define GL_ERROR_H
 
+// How much glGetError polling is compiled in, pick with -DGL_CHECK_MODE=<n>
+// GL_CHECK_OFF: CHECK_GL() and CHECK_GL_STAGE() are no-ops (release benchmarks)
+// GL_CHECK_DEFERRED: only CHECK_GL_STAGE() polls, i.e. once per stage/frame
+// GL_CHECK_STRICT: every CHECK_GL() polls (default)
+#define GL_CHECK_OFF 0
+#define GL_CHECK_DEFERRED 1
+#define GL_CHECK_STRICT 2
+#ifndef GL_CHECK_MODE
+#define GL_CHECK_MODE GL_CHECK_STRICT
+#endif
+
 int _check_gl(char *extra_msg, char *file, int line);
+static inline int _check_gl_off(void) { return 0; }
+
+#if GL_CHECK_MODE >= GL_CHECK_STRICT
 #define CHECK_GL() _check_gl("", __FILE__, __LINE__)
+#else
+#define CHECK_GL() _check_gl_off()
+#endif
+
+#if GL_CHECK_MODE >= GL_CHECK_DEFERRED
+#define CHECK_GL_STAGE(stage) _check_gl(stage, __FILE__, __LINE__)
+#else
+#define CHECK_GL_STAGE(stage) _check_gl_off()
+#endif
 
 #endif
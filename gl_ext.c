@@ -0,0 +1,137 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_ext.h"
+#include "glad/glad.h"
+
+static uint32_t hash_name(const char *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int set_alloc(struct gl_ext_set *set, size_t count, size_t names_bytes) {
+    memset(set, 0, sizeof *set);
+    // keep the load factor at or below 1/2
+    size_t capacity = 16;
+    while (capacity < 2 * count) capacity *= 2;
+    set->slots = (struct gl_ext_slot *)calloc(capacity, sizeof *set->slots);
+    set->names = (char *)malloc(names_bytes ? names_bytes : 1);
+    if (!set->slots || !set->names) {
+        fprintf(stderr, "out of mem\n");
+        gl_ext_set_free(set);
+        return 1;
+    }
+    set->capacity = capacity;
+    return 0;
+}
+
+// name must already live in set->names
+static void set_insert(struct gl_ext_set *set, const char *name, size_t len) {
+    uint32_t h = hash_name(name, len);
+    size_t mask = set->capacity - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        struct gl_ext_slot *slot = &set->slots[i];
+        if (!slot->name) {
+            slot->hash = h;
+            slot->name = name;
+            ++set->count;
+            return;
+        }
+        if (slot->hash == h && !strcmp(slot->name, name)) return;
+    }
+}
+
+int gl_ext_set_build(struct gl_ext_set *set, const char * const *names, size_t count) {
+    size_t names_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (names[i]) names_bytes += strlen(names[i]) + 1;
+    }
+    if (set_alloc(set, count, names_bytes)) return 1;
+    char *dst = set->names;
+    for (size_t i = 0; i < count; ++i) {
+        if (!names[i]) continue;
+        size_t len = strlen(names[i]);
+        memcpy(dst, names[i], len + 1);
+        set_insert(set, dst, len);
+        dst += len + 1;
+    }
+    return 0;
+}
+
+int gl_ext_set_build_from_string(struct gl_ext_set *set, const char *names) {
+    if (!names) names = "";
+    size_t count = 0;
+    for (const char *p = names; *p;) {
+        while (*p == ' ') ++p;
+        if (!*p) break;
+        ++count;
+        while (*p && *p != ' ') ++p;
+    }
+    if (set_alloc(set, count, strlen(names) + 1)) return 1;
+    // copy once, then cut the copy into names in place
+    memcpy(set->names, names, strlen(names) + 1);
+    for (char *p = set->names; *p;) {
+        while (*p == ' ') ++p;
+        if (!*p) break;
+        char *name = p;
+        while (*p && *p != ' ') ++p;
+        size_t len = p - name;
+        if (*p) *p++ = 0;
+        set_insert(set, name, len);
+    }
+    return 0;
+}
+
+int gl_ext_set_has(const struct gl_ext_set *set, const char *name) {
+    if (!set->capacity || !name) return 0;
+    uint32_t h = hash_name(name, strlen(name));
+    size_t mask = set->capacity - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const struct gl_ext_slot *slot = &set->slots[i];
+        if (!slot->name) return 0;
+        if (slot->hash == h && !strcmp(slot->name, name)) return 1;
+    }
+}
+
+void gl_ext_set_free(struct gl_ext_set *set) {
+    free(set->slots);
+    free(set->names);
+    memset(set, 0, sizeof *set);
+}
+
+static struct gl_ext_set context_exts;
+
+int gl_ext_load(void) {
+    gl_ext_set_free(&context_exts);
+    int failed;
+    if (GLVersion.major >= 3) {
+        // GL core profile: GL_EXTENSIONS is only valid for glGetStringi
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        const char **names = (const char **)malloc((count > 0 ? count : 1) * sizeof *names);
+        if (!names) {
+            fprintf(stderr, "out of mem\n");
+            return 1;
+        }
+        for (GLint i = 0; i < count; ++i) {
+            names[i] = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        }
+        failed = gl_ext_set_build(&context_exts, names, count);
+        free(names);
+    } else {
+        failed = gl_ext_set_build_from_string(&context_exts, (const char *)glGetString(GL_EXTENSIONS));
+    }
+    if (!failed) {
+        fprintf(stderr, "GL extensions: %zu\n", context_exts.count);
+    }
+    return failed;
+}
+
+int glsrgb_has_extension(const char *name) {
+    return gl_ext_set_has(&context_exts, name);
+}
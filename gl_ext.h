@@ -0,0 +1,36 @@
+//  MIT license
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Set of extension names built once, queried in O(1) (open addressing
+// on a FNV-1a hash). Names are copied, the source strings can go away.
+struct gl_ext_slot {
+    uint32_t hash;
+    const char *name;
+};
+
+struct gl_ext_set {
+    struct gl_ext_slot *slots;
+    size_t capacity;
+    size_t count;
+    char *names;
+};
+
+// from an array of names (glGetStringi style)
+int gl_ext_set_build(struct gl_ext_set *set, const char * const *names, size_t count);
+// from a space separated list (glGetString(GL_EXTENSIONS) style)
+int gl_ext_set_build_from_string(struct gl_ext_set *set, const char *names);
+int gl_ext_set_has(const struct gl_ext_set *set, const char *name);
+void gl_ext_set_free(struct gl_ext_set *set);
+
+// Builds the extension set of the current context (gl_load_procs does,
+// it needs glGetString, glGetIntegerv and glGetStringi). Returns 1 on
+// failure.
+int gl_ext_load(void);
+// Whether the current context (as of gl_ext_load) supports an extension.
+int glsrgb_has_extension(const char *name);
+
+#endif
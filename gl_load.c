@@ -0,0 +1,155 @@
+//  MIT license
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gl_load.h"
+#include "gl_ext.h"
+#include "gl_timer.h"
+
+struct gl_proc {
+    const char *name;
+    void **proc;
+};
+
+#define GL_PROC(name) {#name, (void **)&glad_##name},
+static const struct gl_proc gl_procs[] = {
+// generated (gen_gl_procs.sh), found on the include path: the cmake
+// build directory, or . for build_srgb.sh
+#include <gl_procs.h>
+};
+#undef GL_PROC
+
+#define GL_PROCS_COUNT (sizeof gl_procs / sizeof gl_procs[0])
+
+// entry points GL ES 2 only has through an extension, taken from the
+// first extension the context has, unless the context is at least the
+// GL ES version (major * 10 + minor) that made the core name part of it.
+// The extension decides, not the pointer: glXGetProcAddress returns a
+// stub for any gl* name.
+struct gl_alias_name {
+    const char *extension;
+    const char *name;
+};
+
+struct gl_alias {
+    const char *name;
+    int core_es_version;
+    struct gl_alias_name gles2_names[3];
+};
+
+static const struct gl_alias gles2_aliases[] = {
+    {"glGenVertexArrays", 30, {{"GL_OES_vertex_array_object", "glGenVertexArraysOES"}}},
+    {"glBindVertexArray", 30, {{"GL_OES_vertex_array_object", "glBindVertexArrayOES"}}},
+    {"glDeleteVertexArrays", 30, {{"GL_OES_vertex_array_object", "glDeleteVertexArraysOES"}}},
+    {"glDrawArraysInstanced", 30, {{"GL_EXT_instanced_arrays", "glDrawArraysInstancedEXT"},
+        {"GL_ANGLE_instanced_arrays", "glDrawArraysInstancedANGLE"}}},
+    {"glVertexAttribDivisor", 30, {{"GL_EXT_instanced_arrays", "glVertexAttribDivisorEXT"},
+        {"GL_ANGLE_instanced_arrays", "glVertexAttribDivisorANGLE"}}},
+    {"glTexStorage2D", 30, {{"GL_EXT_texture_storage", "glTexStorage2DEXT"}}},
+    {"glInvalidateFramebuffer", 30, {{"GL_EXT_discard_framebuffer", "glDiscardFramebufferEXT"}}},
+    {"glGenQueries", 30, {{"GL_EXT_disjoint_timer_query", "glGenQueriesEXT"}, {"GL_EXT_occlusion_query_boolean", "glGenQueriesEXT"}}},
+    {"glDeleteQueries", 30, {{"GL_EXT_disjoint_timer_query", "glDeleteQueriesEXT"}, {"GL_EXT_occlusion_query_boolean", "glDeleteQueriesEXT"}}},
+    {"glBeginQuery", 30, {{"GL_EXT_disjoint_timer_query", "glBeginQueryEXT"}, {"GL_EXT_occlusion_query_boolean", "glBeginQueryEXT"}}},
+    {"glEndQuery", 30, {{"GL_EXT_disjoint_timer_query", "glEndQueryEXT"}, {"GL_EXT_occlusion_query_boolean", "glEndQueryEXT"}}},
+    // not core in any GL ES version
+    {"glGetQueryObjectui64v", 99, {{"GL_EXT_disjoint_timer_query", "glGetQueryObjectui64vEXT"}}},
+    {"glTextureView", 99, {{"GL_OES_texture_view", "glTextureViewOES"}, {"GL_EXT_texture_view", "glTextureViewEXT"}}},
+    {"glDebugMessageCallback", 32, {{"GL_KHR_debug", "glDebugMessageCallbackKHR"}}},
+};
+
+struct gl_proc_table {
+    int loaded;
+    struct gladGLversionStruct version;
+    void *procs[GL_PROCS_COUNT];
+};
+
+static struct gl_proc_table tables[GL_API_COUNT];
+
+const char *gl_api_name(enum gl_api api) {
+    switch (api) {
+        case GL_API_OPENGL: return "gl";
+        case GL_API_GLES2: return "gles2";
+        default: return "unknown";
+    }
+}
+
+static void set_gl_version(void) {
+    // same prefixes as glad's find_core*
+    const char *prefixes[] = {"OpenGL ES-CM ", "OpenGL ES-CL ", "OpenGL ES ", 0};
+    const char *version = (const char *)glGetString(GL_VERSION);
+    GLVersion.major = 0;
+    GLVersion.minor = 0;
+    if (!version) return;
+    for (int i = 0; prefixes[i]; ++i) {
+        size_t n = strlen(prefixes[i]);
+        if (!strncmp(version, prefixes[i], n)) {
+            version += n;
+            break;
+        }
+    }
+    sscanf(version, "%d.%d", &GLVersion.major, &GLVersion.minor);
+}
+
+static void *load_proc(enum gl_api api, GLADloadproc load, const char *name) {
+    if (api == GL_API_GLES2) {
+        for (size_t i = 0; i < sizeof gles2_aliases / sizeof gles2_aliases[0]; ++i) {
+            if (strcmp(gles2_aliases[i].name, name)) continue;
+            if (GLVersion.major * 10 + GLVersion.minor >= gles2_aliases[i].core_es_version) break;
+            for (int j = 0; j < 3 && gles2_aliases[i].gles2_names[j].name; ++j) {
+                const struct gl_alias_name *alias = &gles2_aliases[i].gles2_names[j];
+                if (glsrgb_has_extension(alias->extension)) return load(alias->name);
+            }
+            // not in this context, the core name would only be a stub
+            return 0;
+        }
+    }
+    return load(name);
+}
+
+int gl_load_procs(enum gl_api api, GLADloadproc load) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // needed before anything else to find out the version
+    *(void **)&glad_glGetString = load("glGetString");
+    if (!glad_glGetString) {
+        fprintf(stderr, "failed to load glGetString\n");
+        return 1;
+    }
+    set_gl_version();
+    // the extensions pick the GLES2 aliases
+    *(void **)&glad_glGetIntegerv = load("glGetIntegerv");
+    *(void **)&glad_glGetStringi = GLVersion.major >= 3 ? load("glGetStringi") : 0;
+    if (gl_ext_load()) return 1;
+    struct gl_proc_table *table = &tables[api];
+    // a later context of the same api and version gets the same entry
+    // points (they are per process on GLX and EGL), nothing to resolve
+    if (table->loaded && table->version.major == GLVersion.major && table->version.minor == GLVersion.minor) {
+        gl_use_procs(api);
+        fprintf(stderr, "reused the %s entry points (version %d.%d)\n", gl_api_name(api), GLVersion.major, GLVersion.minor);
+        return 0;
+    }
+    int missing = 0;
+    for (size_t i = 0; i < GL_PROCS_COUNT; ++i) {
+        table->procs[i] = load_proc(api, load, gl_procs[i].name);
+        if (!table->procs[i]) {
+            fprintf(stderr, "%s: %s not available\n", gl_api_name(api), gl_procs[i].name);
+            ++missing;
+        }
+    }
+    table->version = GLVersion;
+    table->loaded = 1;
+    gl_use_procs(api);
+    double ms = gl_timer_elapsed_ms(&start);
+    fprintf(stderr, "loaded %zu %s entry points (%d missing) in %.3f ms (version %d.%d)\n", GL_PROCS_COUNT - missing, gl_api_name(api), missing, ms, GLVersion.major, GLVersion.minor);
+    return 0;
+}
+
+int gl_use_procs(enum gl_api api) {
+    struct gl_proc_table *table = &tables[api];
+    if (!table->loaded) return 1;
+    for (size_t i = 0; i < GL_PROCS_COUNT; ++i) {
+        *gl_procs[i].proc = table->procs[i];
+    }
+    GLVersion = table->version;
+    return 0;
+}
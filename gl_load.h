@@ -0,0 +1,34 @@
+//  MIT license
+#ifndef GL_LOAD_H
+#define GL_LOAD_H
+
+#include "glad/glad.h"
+
+// The binary is built against the GL 4.6 glad header only; a GL ES 2
+// context is driven through the same glad_gl* pointers, loaded with the
+// ES (or ES extension) names. Each API keeps its own resolved table.
+enum gl_api {
+    GL_API_OPENGL,
+    GL_API_GLES2,
+    GL_API_COUNT
+};
+
+const char *gl_api_name(enum gl_api api);
+
+// Resolves only the GL entry points listed in the generated gl_procs.h
+// (see gen_gl_procs.sh) instead of every GL 1.0-4.6 function, for the
+// api of the current context, sets GLVersion and loads the context's
+// extensions (gl_ext_load). Entry points are whatever load returns: on
+// GLX a stub even for functions the context does not have, so check the
+// version or extension (glsrgb_has_extension) before calling one. GLES2
+// aliases are only loaded when their extension is there, 0 otherwise.
+// Returns 1 if glGetString is missing.
+// The table is resolved once per api: a later context of the same api
+// and version only makes it current again.
+// Build with -DGL_LOAD_ALL=1 to use glad's full loader for GL instead.
+int gl_load_procs(enum gl_api api, GLADloadproc load);
+// Makes the table resolved earlier for api current again (without
+// resolving anything), when switching back to a context of that api.
+int gl_use_procs(enum gl_api api);
+
+#endif
@@ -0,0 +1,241 @@
+//  MIT license
+#include "gl_state.h"
+
+// -1: unknown, the next call is issued whatever its value
+#define UNKNOWN -1
+
+static const GLenum cached_caps[] = {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_FRAMEBUFFER_SRGB, GL_SCISSOR_TEST};
+#define CACHED_CAPS_COUNT (sizeof cached_caps / sizeof cached_caps[0])
+
+static const GLenum cached_texture_targets[] = {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY};
+#define CACHED_TEXTURE_TARGETS_COUNT (sizeof cached_texture_targets / sizeof cached_texture_targets[0])
+
+struct gl_state {
+    long program;
+    long vertex_array;
+    long array_buffer;
+    long read_framebuffer;
+    long draw_framebuffer;
+    long active_texture;
+    long textures[GL_STATE_TEXTURE_UNITS][CACHED_TEXTURE_TARGETS_COUNT];
+    long blend_src;
+    long blend_dst;
+    int caps[CACHED_CAPS_COUNT];
+    unsigned long issued;
+    unsigned long skipped;
+};
+
+static struct gl_state state;
+
+// whether the call can be dropped, updates the shadow value otherwise
+static int same(long *shadow, long value) {
+    if (GL_STATE_CACHE && *shadow == value) {
+        ++state.skipped;
+        return 1;
+    }
+    *shadow = value;
+    ++state.issued;
+    return 0;
+}
+
+void gl_state_reset(void) {
+    state.program = UNKNOWN;
+    state.vertex_array = UNKNOWN;
+    state.array_buffer = UNKNOWN;
+    state.read_framebuffer = UNKNOWN;
+    state.draw_framebuffer = UNKNOWN;
+    state.active_texture = UNKNOWN;
+    for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; ++unit) {
+        for (size_t i = 0; i < CACHED_TEXTURE_TARGETS_COUNT; ++i) {
+            state.textures[unit][i] = UNKNOWN;
+        }
+    }
+    state.blend_src = UNKNOWN;
+    state.blend_dst = UNKNOWN;
+    for (size_t i = 0; i < CACHED_CAPS_COUNT; ++i) {
+        state.caps[i] = UNKNOWN;
+    }
+    state.issued = 0;
+    state.skipped = 0;
+}
+
+void gl_state_enable(GLenum cap, int enabled) {
+    enabled = enabled != 0;
+    for (size_t i = 0; i < CACHED_CAPS_COUNT; ++i) {
+        if (cached_caps[i] != cap) continue;
+        if (GL_STATE_CACHE && state.caps[i] == enabled) {
+            ++state.skipped;
+            return;
+        }
+        state.caps[i] = enabled;
+        break;
+    }
+    ++state.issued;
+    if (enabled) {
+        glEnable(cap);
+    } else {
+        glDisable(cap);
+    }
+}
+
+void gl_state_use_program(GLuint program) {
+    if (same(&state.program, program)) return;
+    glUseProgram(program);
+}
+
+void gl_state_bind_vertex_array(GLuint vertex_array) {
+    if (same(&state.vertex_array, vertex_array)) return;
+    glBindVertexArray(vertex_array);
+}
+
+void gl_state_bind_buffer(GLenum target, GLuint buffer) {
+    if (target == GL_ARRAY_BUFFER) {
+        if (same(&state.array_buffer, buffer)) return;
+    } else {
+        // element array buffer is vertex array state, not cached
+        ++state.issued;
+    }
+    glBindBuffer(target, buffer);
+}
+
+void gl_state_bind_framebuffer(GLuint framebuffer) {
+    if (GL_STATE_CACHE && state.read_framebuffer == framebuffer && state.draw_framebuffer == framebuffer) {
+        ++state.skipped;
+        return;
+    }
+    state.read_framebuffer = framebuffer;
+    state.draw_framebuffer = framebuffer;
+    ++state.issued;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void gl_state_bind_framebuffers(GLuint read_framebuffer, GLuint draw_framebuffer) {
+    if (read_framebuffer == draw_framebuffer) {
+        gl_state_bind_framebuffer(read_framebuffer);
+        return;
+    }
+    if (!same(&state.read_framebuffer, read_framebuffer)) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+    }
+    if (!same(&state.draw_framebuffer, draw_framebuffer)) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer);
+    }
+}
+
+void gl_state_bind_texture(int unit, GLenum target, GLuint texture) {
+    // always leaves unit active, callers may go on with glTex* calls
+    if (!same(&state.active_texture, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    for (size_t i = 0; i < CACHED_TEXTURE_TARGETS_COUNT && unit < GL_STATE_TEXTURE_UNITS; ++i) {
+        if (cached_texture_targets[i] != target) continue;
+        if (GL_STATE_CACHE && state.textures[unit][i] == texture) {
+            ++state.skipped;
+            return;
+        }
+        state.textures[unit][i] = texture;
+        break;
+    }
+    ++state.issued;
+    glBindTexture(target, texture);
+}
+
+void gl_state_blend_func(GLenum src, GLenum dst) {
+    if (GL_STATE_CACHE && state.blend_src == src && state.blend_dst == dst) {
+        ++state.skipped;
+        return;
+    }
+    state.blend_src = src;
+    state.blend_dst = dst;
+    ++state.issued;
+    glBlendFunc(src, dst);
+}
+
+static void forget(long *shadow, GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; ++i) {
+        // deleting a bound object binds 0 in its place
+        if (*shadow == names[i]) *shadow = 0;
+    }
+}
+
+void gl_state_delete_program(GLuint program) {
+    // a deleted program stays current until replaced, but its name can be
+    // handed out again, so the next use must always be issued
+    if (state.program == program) state.program = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void gl_state_delete_vertex_arrays(GLsizei n, const GLuint *vertex_arrays) {
+    forget(&state.vertex_array, n, vertex_arrays);
+    glDeleteVertexArrays(n, vertex_arrays);
+}
+
+void gl_state_delete_buffers(GLsizei n, const GLuint *buffers) {
+    forget(&state.array_buffer, n, buffers);
+    glDeleteBuffers(n, buffers);
+}
+
+void gl_state_delete_framebuffers(GLsizei n, const GLuint *framebuffers) {
+    forget(&state.read_framebuffer, n, framebuffers);
+    forget(&state.draw_framebuffer, n, framebuffers);
+    glDeleteFramebuffers(n, framebuffers);
+}
+
+void gl_state_delete_textures(GLsizei n, const GLuint *textures) {
+    for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; ++unit) {
+        for (size_t i = 0; i < CACHED_TEXTURE_TARGETS_COUNT; ++i) {
+            forget(&state.textures[unit][i], n, textures);
+        }
+    }
+    glDeleteTextures(n, textures);
+}
+
+void gl_state_stats(unsigned long *issued, unsigned long *skipped) {
+    *issued = state.issued;
+    *skipped = state.skipped;
+}
+
+void gl_uniform_cache_reset(struct gl_uniform_cache *cache) {
+    cache->count = 0;
+}
+
+// slot for location, 0 if the cache is full
+static GLfloat *uniform_slot(struct gl_uniform_cache *cache, GLint location, int *is_new) {
+    for (int i = 0; i < cache->count; ++i) {
+        if (cache->location[i] == location) {
+            *is_new = 0;
+            return cache->value[i];
+        }
+    }
+    if (cache->count == GL_UNIFORM_CACHE_SIZE) return 0;
+    *is_new = 1;
+    cache->location[cache->count] = location;
+    return cache->value[cache->count++];
+}
+
+void gl_state_uniform1i(struct gl_uniform_cache *cache, GLint location, GLint value) {
+    int is_new = 1;
+    GLfloat *slot = uniform_slot(cache, location, &is_new);
+    if (GL_STATE_CACHE && slot && !is_new && slot[0] == (GLfloat)value) {
+        ++state.skipped;
+        return;
+    }
+    if (slot) slot[0] = (GLfloat)value;
+    ++state.issued;
+    glUniform1i(location, value);
+}
+
+void gl_state_uniform2f(struct gl_uniform_cache *cache, GLint location, GLfloat x, GLfloat y) {
+    int is_new = 1;
+    GLfloat *slot = uniform_slot(cache, location, &is_new);
+    if (GL_STATE_CACHE && slot && !is_new && slot[0] == x && slot[1] == y) {
+        ++state.skipped;
+        return;
+    }
+    if (slot) {
+        slot[0] = x;
+        slot[1] = y;
+    }
+    ++state.issued;
+    glUniform2f(location, x, y);
+}
@@ -0,0 +1,56 @@
+//  MIT license
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "glad/glad.h"
+
+// Shadow copy of the GL state the harness touches per draw, calls that
+// would not change anything are dropped before they reach the driver.
+// All binds/enables of cached state must go through here (or be followed
+// by gl_state_reset()), and a new/other context needs gl_state_reset().
+// Build with -DGL_STATE_CACHE=0 to forward every call (for comparison).
+#ifndef GL_STATE_CACHE
+#define GL_STATE_CACHE 1
+#endif
+
+#define GL_STATE_TEXTURE_UNITS 8
+
+// forget everything, next call of each kind is always issued
+void gl_state_reset(void);
+void gl_state_enable(GLenum cap, int enabled);
+void gl_state_use_program(GLuint program);
+void gl_state_bind_vertex_array(GLuint vertex_array);
+void gl_state_bind_buffer(GLenum target, GLuint buffer);
+// both read and draw
+void gl_state_bind_framebuffer(GLuint framebuffer);
+// separately, e.g. for glBlitFramebuffer
+void gl_state_bind_framebuffers(GLuint read_framebuffer, GLuint draw_framebuffer);
+// also makes unit the active texture unit
+void gl_state_bind_texture(int unit, GLenum target, GLuint texture);
+void gl_state_blend_func(GLenum src, GLenum dst);
+// delete and drop from the cache, so a recycled name is bound again
+void gl_state_delete_program(GLuint program);
+void gl_state_delete_vertex_arrays(GLsizei n, const GLuint *vertex_arrays);
+void gl_state_delete_buffers(GLsizei n, const GLuint *buffers);
+void gl_state_delete_framebuffers(GLsizei n, const GLuint *framebuffers);
+void gl_state_delete_textures(GLsizei n, const GLuint *textures);
+
+// calls forwarded to GL / dropped as redundant since the last reset
+void gl_state_stats(unsigned long *issued, unsigned long *skipped);
+
+// Cache for the uniforms of one program (uniforms are program state),
+// keyed by location, for the few scalar/vec2 uniforms set per draw.
+#define GL_UNIFORM_CACHE_SIZE 8
+
+struct gl_uniform_cache {
+    GLint location[GL_UNIFORM_CACHE_SIZE];
+    GLfloat value[GL_UNIFORM_CACHE_SIZE][2];
+    int count;
+};
+
+void gl_uniform_cache_reset(struct gl_uniform_cache *cache);
+// program must be in use
+void gl_state_uniform1i(struct gl_uniform_cache *cache, GLint location, GLint value);
+void gl_state_uniform2f(struct gl_uniform_cache *cache, GLint location, GLfloat x, GLfloat y);
+
+#endif
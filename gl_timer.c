@@ -0,0 +1,48 @@
+//  MIT license
+#include "gl_timer.h"
+#include "gl_error.h"
+#include "gl_ext.h"
+
+static int has_timer_query(enum gl_api api) {
+    if (api == GL_API_OPENGL) {
+        if (GLVersion.major > 3 || (GLVersion.major == 3 && GLVersion.minor >= 3)) return 1;
+        return glsrgb_has_extension("GL_ARB_timer_query");
+    }
+    return glsrgb_has_extension("GL_EXT_disjoint_timer_query");
+}
+
+int gl_timer_setup(struct gl_timer *timer, enum gl_api api) {
+    timer->query = 0;
+    timer->supported = has_timer_query(api) && glGenQueries && glBeginQuery && glEndQuery && glGetQueryObjectui64v;
+    if (!timer->supported) return 1;
+    glGenQueries(1, &timer->query); CHECK_GL();
+    return 0;
+}
+
+void gl_timer_begin(struct gl_timer *timer) {
+    if (!timer->supported) return;
+    glBeginQuery(GL_TIME_ELAPSED, timer->query); CHECK_GL();
+}
+
+void gl_timer_end(struct gl_timer *timer) {
+    if (!timer->supported) return;
+    glEndQuery(GL_TIME_ELAPSED); CHECK_GL();
+}
+
+double gl_timer_ms(struct gl_timer *timer) {
+    if (!timer->supported) return -1;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(timer->query, GL_QUERY_RESULT, &ns); CHECK_GL();
+    return ns * 1e-6;
+}
+
+void gl_timer_teardown(struct gl_timer *timer) {
+    if (timer->query) glDeleteQueries(1, &timer->query);
+    timer->query = 0;
+}
+
+double gl_timer_elapsed_ms(const struct timespec *start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e3 + (end.tv_nsec - start->tv_nsec) * 1e-6;
+}
@@ -0,0 +1,27 @@
+//  MIT license
+#ifndef GL_TIMER_H
+#define GL_TIMER_H
+
+#include <time.h>
+#include "glad/glad.h"
+#include "gl_load.h"
+
+// GPU time of the commands between begin and end, from a
+// GL_TIME_ELAPSED query (GL 3.3 / ARB_timer_query, or
+// GL_EXT_disjoint_timer_query on GL ES). Without either every call is
+// a no-op and gl_timer_ms returns -1.
+struct gl_timer {
+    GLuint query;
+    int supported;
+};
+
+int gl_timer_setup(struct gl_timer *timer, enum gl_api api);
+void gl_timer_begin(struct gl_timer *timer);
+void gl_timer_end(struct gl_timer *timer);
+// waits for the result of the last begin/end
+double gl_timer_ms(struct gl_timer *timer);
+void gl_timer_teardown(struct gl_timer *timer);
+// CPU side: ms since start, a CLOCK_MONOTONIC clock_gettime
+double gl_timer_elapsed_ms(const struct timespec *start);
+
+#endif
@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <glad/glad.h>
+#include "gl_ext.h"
 
 static void* get_proc(const char *namez);
 
@@ -163,6 +164,8 @@ static int max_loaded_minor;
 static const char *exts = NULL;
 static int num_exts_i = 0;
 static char **exts_i = NULL;
+/* exts/exts_i hashed once, so each has_ext is O(1) */
+static struct gl_ext_set exts_set;
 
 static int get_exts(void) {
 #ifdef _GLAD_IS_SOME_NEW_VERSION
@@ -199,10 +202,16 @@ static int get_exts(void) {
         }
     }
 #endif
-    return 1;
+#ifdef _GLAD_IS_SOME_NEW_VERSION
+    if(max_loaded_major >= 3) {
+        return !gl_ext_set_build(&exts_set, (const char * const *)exts_i, (size_t)num_exts_i);
+    }
+#endif
+    return !gl_ext_set_build_from_string(&exts_set, exts);
 }
 
 static void free_exts(void) {
+    gl_ext_set_free(&exts_set);
     if (exts_i != NULL) {
         int index;
         for(index = 0; index < num_exts_i; index++) {
@@ -214,45 +223,7 @@ static void free_exts(void) {
 }
 
 static int has_ext(const char *ext) {
-#ifdef _GLAD_IS_SOME_NEW_VERSION
-    if(max_loaded_major < 3) {
-#endif
-        const char *extensions;
-        const char *loc;
-        const char *terminator;
-        extensions = exts;
-        if(extensions == NULL || ext == NULL) {
-            return 0;
-        }
-
-        while(1) {
-            loc = strstr(extensions, ext);
-            if(loc == NULL) {
-                return 0;
-            }
-
-            terminator = loc + strlen(ext);
-            if((loc == extensions || *(loc - 1) == ' ') &&
-                (*terminator == ' ' || *terminator == '\0')) {
-                return 1;
-            }
-            extensions = terminator;
-        }
-#ifdef _GLAD_IS_SOME_NEW_VERSION
-    } else {
-        int index;
-        if(exts_i == NULL) return 0;
-        for(index = 0; index < num_exts_i; index++) {
-            const char *e = exts_i[index];
-
-            if(exts_i[index] != NULL && strcmp(e, ext) == 0) {
-                return 1;
-            }
-        }
-    }
-#endif
-
-    return 0;
+    return gl_ext_set_has(&exts_set, ext);
 }
 int GLAD_GL_VERSION_1_0;
 int GLAD_GL_VERSION_1_1;
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <glad/glad_glx.h>
+#include "gl_ext.h"
 
 static void* get_proc(const char *namez);
 
@@ -158,42 +159,24 @@ int gladLoadGLX(Display *dpy, int screen) {
 static Display *GLADGLXDisplay = 0;
 static int GLADGLXscreen = 0;
 
+/* the extension string hashed once, so each has_ext is O(1) */
+static struct gl_ext_set exts_set;
+
 static int get_exts(void) {
-    return 1;
+    const char *extensions = NULL;
+
+    if(GLAD_GLX_VERSION_1_1)
+        extensions = glXQueryExtensionsString(GLADGLXDisplay, GLADGLXscreen);
+
+    return !gl_ext_set_build_from_string(&exts_set, extensions);
 }
 
 static void free_exts(void) {
-    return;
+    gl_ext_set_free(&exts_set);
 }
 
 static int has_ext(const char *ext) {
-    const char *terminator;
-    const char *loc;
-    const char *extensions;
-
-    if(!GLAD_GLX_VERSION_1_1)
-        return 0;
-
-    extensions = glXQueryExtensionsString(GLADGLXDisplay, GLADGLXscreen);
-
-    if(extensions == NULL || ext == NULL)
-        return 0;
-
-    while(1) {
-        loc = strstr(extensions, ext);
-        if(loc == NULL)
-            break;
-
-        terminator = loc + strlen(ext);
-        if((loc == extensions || *(loc - 1) == ' ') &&
-            (*terminator == ' ' || *terminator == '\0'))
-        {
-            return 1;
-        }
-        extensions = terminator;
-    }
-
-    return 0;
+    return gl_ext_set_has(&exts_set, ext);
 }
 
 int GLAD_GLX_VERSION_1_0;
@@ -0,0 +1,324 @@
+//  MIT license
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "golden.h"
+
+#define OBJECT_MAGIC "GLSG"
+#define PATH_SIZE 1024
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t golden_hash(const uint8_t *pixels, int width, int height) {
+    size_t size = (size_t)width * height * 4;
+    uint64_t seed = mix(((uint64_t)width << 32) | (uint32_t)height);
+    // four independent lanes of 8 bytes, so a frame hashes at memory speed
+    uint64_t lanes[4] = {seed, seed ^ 0x9e3779b97f4a7c15ULL, seed ^ 0xbf58476d1ce4e5b9ULL, seed ^ 0x94d049bb133111ebULL};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t word;
+            memcpy(&word, pixels + i + l * 8, 8);
+            lanes[l] = (lanes[l] ^ word) * 0x100000001b3ULL;
+            lanes[l] ^= lanes[l] >> 29;
+        }
+    }
+    uint64_t h = seed;
+    for (; i < size; ++i) {
+        h = (h ^ pixels[i]) * 0x100000001b3ULL;
+    }
+    for (int l = 0; l < 4; ++l) {
+        h = mix(h ^ lanes[l]);
+    }
+    return h;
+}
+
+static void object_path(const struct golden_store *store, uint64_t hash, char *path) {
+    snprintf(path, PATH_SIZE, "%s/objects/%016" PRIx64 ".z", store->dir, hash);
+}
+
+static int make_dir(const char *path) {
+    if (mkdir(path, 0777) && errno != EEXIST) {
+        fprintf(stderr, "golden: cannot create %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+// names are cut to fit, tabs and newlines would break the index
+static void normalize(char *dst, size_t size, const char *name) {
+    snprintf(dst, size, "%s", name);
+    for (char *c = dst; *c; ++c) {
+        if (*c == '\t' || *c == '\n') *c = ' ';
+    }
+}
+
+// FNV-1a of the normalized case and driver, with the 0 between them
+static uint32_t key_hash(const char *case_key, const char *driver_key) {
+    uint32_t h = 2166136261u;
+    for (const char *c = case_key;; ++c) {
+        h ^= (uint8_t)*c;
+        h *= 16777619u;
+        if (!*c) break;
+    }
+    for (const char *c = driver_key; *c; ++c) {
+        h ^= (uint8_t)*c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void slots_insert(struct golden_store *store, int index) {
+    size_t mask = store->slots_capacity - 1;
+    for (size_t i = store->entries[index].key_hash & mask;; i = (i + 1) & mask) {
+        if (!store->slots[i]) {
+            store->slots[i] = index + 1;
+            return;
+        }
+    }
+}
+
+// keeps the load factor at or below 1/2
+static int slots_reserve(struct golden_store *store, int count) {
+    if (2 * count <= store->slots_capacity) return 0;
+    int capacity = store->slots_capacity ? store->slots_capacity : 128;
+    while (capacity < 2 * count) capacity *= 2;
+    int *slots = calloc(capacity, sizeof *slots);
+    if (!slots) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    free(store->slots);
+    store->slots = slots;
+    store->slots_capacity = capacity;
+    for (int i = 0; i < store->count; ++i) {
+        slots_insert(store, i);
+    }
+    return 0;
+}
+
+static struct golden_entry *find(const struct golden_store *store, const char *case_name, const char *driver) {
+    if (!store->slots_capacity) return 0;
+    char case_key[GOLDEN_CASE_SIZE], driver_key[GOLDEN_DRIVER_SIZE];
+    normalize(case_key, sizeof case_key, case_name);
+    normalize(driver_key, sizeof driver_key, driver);
+    uint32_t h = key_hash(case_key, driver_key);
+    size_t mask = store->slots_capacity - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        if (!store->slots[i]) return 0;
+        struct golden_entry *entry = store->entries + store->slots[i] - 1;
+        if (entry->key_hash == h && !strcmp(entry->case_name, case_key) && !strcmp(entry->driver, driver_key)) return entry;
+    }
+}
+
+static struct golden_entry *add(struct golden_store *store, const char *case_name, const char *driver) {
+    if (slots_reserve(store, store->count + 1)) return 0;
+    if (store->count == store->capacity) {
+        int capacity = store->capacity ? store->capacity * 2 : 64;
+        struct golden_entry *entries = realloc(store->entries, capacity * sizeof (struct golden_entry));
+        if (!entries) {
+            fprintf(stderr, "out of mem\n");
+            return 0;
+        }
+        store->entries = entries;
+        store->capacity = capacity;
+    }
+    struct golden_entry *entry = store->entries + store->count++;
+    normalize(entry->case_name, sizeof entry->case_name, case_name);
+    normalize(entry->driver, sizeof entry->driver, driver);
+    entry->key_hash = key_hash(entry->case_name, entry->driver);
+    entry->hash = 0;
+    entry->width = 0;
+    entry->height = 0;
+    slots_insert(store, store->count - 1);
+    return entry;
+}
+
+// index lines: hash, width, height, case, driver, separated by tabs
+static int read_index(struct golden_store *store) {
+    char path[PATH_SIZE];
+    snprintf(path, sizeof path, "%s/index", store->dir);
+    FILE *file = fopen(path, "r");
+    if (!file) return errno == ENOENT ? 0 : 1;
+    char line[512];
+    while (fgets(line, sizeof line, file)) {
+        if (line[0] == '#') continue;
+        line[strcspn(line, "\n")] = 0;
+        uint64_t hash;
+        int width, height, n = 0;
+        if (sscanf(line, "%" SCNx64 "\t%d\t%d\t%n", &hash, &width, &height, &n) != 3 || !n) continue;
+        char *case_name = line + n;
+        char *driver = strchr(case_name, '\t');
+        if (!driver) continue;
+        *driver++ = 0;
+        // a key listed twice keeps its last line
+        struct golden_entry *entry = find(store, case_name, driver);
+        if (!entry) entry = add(store, case_name, driver);
+        if (!entry) break;
+        entry->hash = hash;
+        entry->width = width;
+        entry->height = height;
+    }
+    fclose(file);
+    return 0;
+}
+
+int golden_store_open(struct golden_store *store, const char *dir) {
+    memset(store, 0, sizeof *store);
+    store->dir = strdup(dir);
+    if (!store->dir) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    char path[PATH_SIZE];
+    snprintf(path, sizeof path, "%s/objects", dir);
+    if (make_dir(dir) || make_dir(path)) return 1;
+    if (read_index(store)) {
+        fprintf(stderr, "golden: cannot read the index of %s\n", dir);
+        return 1;
+    }
+    return 0;
+}
+
+int golden_store_lookup(const struct golden_store *store, const char *case_name, const char *driver, uint64_t *hash, int *width,
+        int *height) {
+    const struct golden_entry *entry = find(store, case_name, driver);
+    if (!entry) return 1;
+    *hash = entry->hash;
+    *width = entry->width;
+    *height = entry->height;
+    return 0;
+}
+
+// deflated into a temporary file renamed into place, so an object that
+// exists is complete
+static int write_object(struct golden_store *store, uint64_t hash, const uint8_t *pixels, int width, int height) {
+    uLong size = (uLong)width * height * 4;
+    uLongf compressed_size = compressBound(size);
+    uint8_t *compressed = malloc(compressed_size);
+    if (!compressed) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    // frames are mostly flat, the fastest level is close to the best
+    if (compress2(compressed, &compressed_size, pixels, size, 1) != Z_OK) {
+        fprintf(stderr, "golden: deflate failed\n");
+        free(compressed);
+        return 1;
+    }
+    char path[PATH_SIZE], tmp_path[PATH_SIZE + 8];
+    object_path(store, hash, path);
+    snprintf(tmp_path, sizeof tmp_path, "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    uint32_t header[2] = {width, height};
+    int failed = !file || fwrite(OBJECT_MAGIC, 4, 1, file) != 1 || fwrite(header, sizeof header, 1, file) != 1 ||
+        fwrite(compressed, compressed_size, 1, file) != 1;
+    if (file && fclose(file)) failed = 1;
+    free(compressed);
+    if (failed || rename(tmp_path, path)) {
+        fprintf(stderr, "golden: cannot write %s: %s\n", path, strerror(errno));
+        remove(tmp_path);
+        return 1;
+    }
+    ++store->written;
+    store->written_bytes += 4 + sizeof header + compressed_size;
+    return 0;
+}
+
+int golden_store_put(struct golden_store *store, const char *case_name, const char *driver, const uint8_t *pixels, int width, int height,
+        enum golden_status *status) {
+    uint64_t hash = golden_hash(pixels, width, height);
+    char path[PATH_SIZE];
+    object_path(store, hash, path);
+    if (!access(path, F_OK)) {
+        ++store->deduplicated;
+    } else if (write_object(store, hash, pixels, width, height)) {
+        return 1;
+    }
+    struct golden_entry *entry = find(store, case_name, driver);
+    *status = !entry ? GOLDEN_NEW : entry->hash == hash ? GOLDEN_SAME : GOLDEN_CHANGED;
+    if (!entry) entry = add(store, case_name, driver);
+    if (!entry) return 1;
+    if (entry->hash != hash || entry->width != width || entry->height != height) store->dirty = 1;
+    entry->hash = hash;
+    entry->width = width;
+    entry->height = height;
+    ++store->puts;
+    return 0;
+}
+
+int golden_store_load(const struct golden_store *store, uint64_t hash, uint8_t *pixels, int width, int height) {
+    char path[PATH_SIZE];
+    object_path(store, hash, path);
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "golden: no object %016" PRIx64 "\n", hash);
+        return 1;
+    }
+    char magic[4];
+    uint32_t header[2];
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    long compressed_size = file_size - 4 - (long)sizeof header;
+    uint8_t *compressed = compressed_size > 0 ? malloc(compressed_size) : 0;
+    int failed = !compressed || fread(magic, 4, 1, file) != 1 || fread(header, sizeof header, 1, file) != 1 ||
+        fread(compressed, compressed_size, 1, file) != 1;
+    fclose(file);
+    uLongf size = (uLongf)width * height * 4;
+    if (!failed && (memcmp(magic, OBJECT_MAGIC, 4) || header[0] != (uint32_t)width || header[1] != (uint32_t)height)) {
+        fprintf(stderr, "golden: %s is not a %dx%d frame\n", path, width, height);
+        failed = 1;
+    } else if (!failed && (uncompress(pixels, &size, compressed, compressed_size) != Z_OK || size != (uLongf)width * height * 4)) {
+        fprintf(stderr, "golden: %s is corrupt\n", path);
+        failed = 1;
+    }
+    free(compressed);
+    return failed;
+}
+
+int golden_store_close(struct golden_store *store) {
+    int failed = 0;
+    if (store->dirty) {
+        char path[PATH_SIZE], tmp_path[PATH_SIZE + 8];
+        snprintf(path, sizeof path, "%s/index", store->dir);
+        snprintf(tmp_path, sizeof tmp_path, "%s.tmp", path);
+        FILE *file = fopen(tmp_path, "w");
+        failed = !file;
+        if (file) {
+            fprintf(file, "# hash\twidth\theight\tcase\tdriver\n");
+            for (int i = 0; i < store->count; ++i) {
+                const struct golden_entry *entry = store->entries + i;
+                fprintf(file, "%016" PRIx64 "\t%d\t%d\t%s\t%s\n", entry->hash, entry->width, entry->height, entry->case_name, entry->driver);
+            }
+            if (fclose(file)) failed = 1;
+        }
+        if (failed || rename(tmp_path, path)) {
+            fprintf(stderr, "golden: cannot write %s: %s\n", path, strerror(errno));
+            failed = 1;
+        }
+    }
+    free(store->entries);
+    free(store->slots);
+    free(store->dir);
+    store->entries = 0;
+    store->slots = 0;
+    store->dir = 0;
+    store->count = 0;
+    store->capacity = 0;
+    store->slots_capacity = 0;
+    store->dirty = 0;
+    return failed;
+}
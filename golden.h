@@ -0,0 +1,68 @@
+//  MIT license
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Content addressed store of readbacks on local disk, to track frames
+// across runs and driver versions. A frame is keyed by the hash of its
+// size and pixels and written once, deflated, as objects/<hash>.z under
+// the store directory: identical frames of other cases, drivers or runs
+// share it. The index file maps (case, driver) to the hash of the last
+// frame stored for it, kept in a hash table while open, so comparing a
+// run with the previous one is a hash compare per case, not a pixel diff.
+#define GOLDEN_CASE_SIZE 64
+#define GOLDEN_DRIVER_SIZE 192
+
+struct golden_entry {
+    char case_name[GOLDEN_CASE_SIZE];
+    char driver[GOLDEN_DRIVER_SIZE];
+    // of (case_name, driver), for the table
+    uint32_t key_hash;
+    uint64_t hash;
+    int width, height;
+};
+
+struct golden_store {
+    char *dir;
+    // in index order, for writing it back
+    struct golden_entry *entries;
+    int count;
+    int capacity;
+    // open addressed on key_hash: entry index + 1, 0 if empty
+    int *slots;
+    int slots_capacity;
+    int dirty;
+    // this session: frames put, objects written (and their deflated
+    // bytes), frames whose object was already there
+    unsigned long puts;
+    unsigned long written;
+    unsigned long written_bytes;
+    unsigned long deduplicated;
+};
+
+enum golden_status {
+    GOLDEN_NEW,
+    GOLDEN_SAME,
+    GOLDEN_CHANGED,
+};
+
+// 64-bit hash of rgba8 pixels and their size
+uint64_t golden_hash(const uint8_t *pixels, int width, int height);
+// creates dir (and dir/objects) if needed, loads the index
+int golden_store_open(struct golden_store *store, const char *dir);
+// hash and size of the frame recorded for (case, driver), 1 if none
+int golden_store_lookup(const struct golden_store *store, const char *case_name, const char *driver, uint64_t *hash, int *width,
+    int *height);
+// stores width x height rgba8 pixels as the frame of (case, driver) and
+// tells how it compares with the one recorded before
+int golden_store_put(struct golden_store *store, const char *case_name, const char *driver, const uint8_t *pixels, int width, int height,
+    enum golden_status *status);
+// the pixels of a stored frame (e.g. one from golden_store_lookup, to
+// diff a changed frame with), width * height * 4 bytes
+int golden_store_load(const struct golden_store *store, uint64_t hash, uint8_t *pixels, int width, int height);
+// writes the index if it changed
+int golden_store_close(struct golden_store *store);
+
+#endif
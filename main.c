@@ -3,62 +3,51 @@
 #include "glad/glad.h"
 #include "glad/glad_glx.h"
 
-#ifdef __gl_h_
-#define USE_OPENGL 1
-#define USE_GLES 0
-#define USE_GLES2 0
-#define USE_GLES3 0
-#elif defined(__gl2_h_)
-#define USE_OPENGL 0
-#define USE_GLES 1
-#define USE_GLES2 1
-#define USE_GLES3 0
-// be more like GLES3
-#define GL_SRGB8_ALPHA8 GL_SRGB8_ALPHA8_EXT
-#define glGenVertexArrays glGenVertexArraysOES
-#define glBindVertexArray glBindVertexArrayOES
-#define glDeleteVertexArrays glDeleteVertexArraysOES
-#define GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING_EXT
+// GL and GL ES 2 are both driven through the GL 4.6 glad header, the api
+// is picked per context at runtime (see gl_load.h).
+// GL ES 2 + GL_EXT_sRGB use the same values as the GL core names for
+// GL_SRGB8_ALPHA8 and GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING,
 // seems GL_EXT_sRGB does not specify values for LINEAR/SRGB that
 // would be returned when querying GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING
-// assuming here that it is the same as in GL ES 3
-#define GL_LINEAR 0x2601
-#define GL_SRGB 0x8C40
-#elif defined(__gl3_h_)
-#define USE_OPENGL 0
-#define USE_GLES 1
-#define USE_GLES2 0
-#define USE_GLES3 1
-#endif
-
-#if !USE_OPENGL && !USE_GLES
-#error Cannot figure out what OpenGL/GL ES you are running.
-#endif
-
-#if USE_OPENGL
-#include <GL/gl.h>
-#endif
-#if USE_GLES
-#include <GLES2/gl2.h>
-#endif
+// assuming here that it is the same as in GL ES 3 (and GL)
+// these are gone from the GL core header, but are what GL ES 2 has
+#define GL_RED_BITS 0x0D52
+#define GL_GREEN_BITS 0x0D53
+#define GL_BLUE_BITS 0x0D54
+#define GL_ALPHA_BITS 0x0D55
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
+#include <time.h>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #include "gl_compile.h"
 #include "gl_error.h"
+#include "gl_debug.h"
+#include "gl_load.h"
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "scene.h"
+#include "fborender.h"
+#include "gl_timer.h"
+#include "msaa.h"
+#include "blend_sweep.h"
+#include "decode_check.h"
+#include "golden.h"
+#include "frame_diff.h"
 
 struct glx_handles {
     Display *dpy;
     Window win;
+    GLXFBConfig fbconfig;
     GLXContext glc;
+    enum gl_api api;
     GLint gl_major;
 };
 
-int setup_gl_context(int width, int height, struct glx_handles *out) {
+int setup_window(int width, int height, struct glx_handles *out) {
     Display *dpy = XOpenDisplay(0);
     if (!dpy) {
         fprintf(stderr, "XOpenDisplay returned 0\n");
@@ -118,456 +107,587 @@ int setup_gl_context(int width, int height, struct glx_handles *out) {
         fprintf(stderr, "XMapWindow failed\n");
         return 1;
     }
+    out->dpy = dpy;
+    out->win = win;
+    out->fbconfig = fbconfig;
+    out->glc = 0;
+    return 0;
+}
+
+void teardown_window(struct glx_handles *glx) {
+    XDestroyWindow(glx->dpy, glx->win);
+    XCloseDisplay(glx->dpy);
+}
+
+// creates a context for api on the window from setup_window and makes it current
+int setup_gl_context(enum gl_api api, int debug, struct glx_handles *out) {
     //GLXContext glc = glXCreateContext(dpy, vi, NULL, GL_TRUE);
-#if USE_OPENGL
-    int const attrib_list[] = {
+    int const gl_attrib_list[] = {
         GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
         GLX_CONTEXT_MINOR_VERSION_ARB, 6,
-        GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB, None};
-#elif USE_GLES
-    int const attrib_list[] = {
+        GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+        GLX_CONTEXT_FLAGS_ARB, debug ? GLX_CONTEXT_DEBUG_BIT_ARB : 0, None};
+    int const gles2_attrib_list[] = {
         GLX_CONTEXT_MAJOR_VERSION_ARB, 2,
         GLX_CONTEXT_MINOR_VERSION_ARB, 0,
-        GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_ES2_PROFILE_BIT_EXT, None};
-#endif
-    GLXContext glc = glXCreateContextAttribsARB(dpy, fbconfig, NULL, GL_TRUE, attrib_list);
+        GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_ES2_PROFILE_BIT_EXT,
+        GLX_CONTEXT_FLAGS_ARB, debug ? GLX_CONTEXT_DEBUG_BIT_ARB : 0, None};
+    int const *attrib_list = api == GL_API_OPENGL ? gl_attrib_list : gles2_attrib_list;
+    GLXContext glc = glXCreateContextAttribsARB(out->dpy, out->fbconfig, NULL, GL_TRUE, attrib_list);
     if (!glc) {
         fprintf(stderr, "glXCreateContext failed\n");
         return 1;
     }
-    if (!glXMakeCurrent(dpy, win, glc)) {
+    if (!glXMakeCurrent(out->dpy, out->win, glc)) {
         fprintf(stderr, "glXMakeCurrent failed\n");
         return 1;
     }
-#if USE_OPENGL
-    if (!gladLoadGLLoader((GLADloadproc)glXGetProcAddress)) {
-        fprintf(stderr, "gladLoadGLLoader failed\n");
-        return 1;
-    }
-#elif USE_GLES
-    if (!gladLoadGLES2Loader((GLADloadproc)glXGetProcAddress)) {
-        fprintf(stderr, "gladLoadGLES2Loader failed\n");
+#if GL_LOAD_ALL
+    if (api == GL_API_OPENGL) {
+        if (!gladLoadGLLoader((GLADloadproc)glXGetProcAddress) || gl_ext_load()) {
+            fprintf(stderr, "gladLoadGLLoader failed\n");
+            return 1;
+        }
+    } else
+#endif
+    if (gl_load_procs(api, (GLADloadproc)glXGetProcAddress)) {
+        fprintf(stderr, "gl_load_procs failed\n");
         return 1;
     }
-#endif
+    gl_state_reset();
     const char *version = (char *)glGetString(GL_VERSION);
     if (!version) {
         fprintf(stderr, "glGetString(GL_VERSION) failed\n");
         return 1;
     }
     fprintf(stderr, "glGetString(GL_VERSION): %s\n", version);
-    out->dpy = dpy;
-    // 10th is always <version number> (and so far 3 or 2 => < 9)
-    out->win = win;
+    if (debug && gl_debug_setup(api, debug > 1)) {
+        fprintf(stderr, "continuing without GL debug output\n");
+    }
     out->glc = glc;
-    // assume version < 10
-    // OpenGL<space>ES<space><version number><space><vendor-specific information>
-    // 10th is always <version number> (and so far 3 or 2 => < 9)
-    out->gl_major = version[10] - '0'; 
+    out->api = api;
+    // e.g. 4 for GL 4.6, 3 when asking for GL ES 2 but getting GL ES 3.2
+    out->gl_major = GLVersion.major;
     if (CHECK_GL()) return 1;
     return 0;
 }
 
-struct quadtest {
-    GLuint program;
-    GLuint position_index;
-    GLuint uv_index;
-    GLint texture_location;
-    GLint ramp_location;
-    GLint offset_location;
-    GLint scale_location;
-    GLuint vertex_array;
-    GLuint vertex_buffer;
-    int vertices_count;
-};
-
-GLuint create_a_texture(uint8_t *pixels, int width, int height) {
-    GLuint texture = 0;
-    glGenTextures(1, &texture); CHECK_GL();
-    glBindTexture(GL_TEXTURE_2D, texture); CHECK_GL();
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    return texture;
-}
-
-GLuint create_srgb8_a8_texture(uint8_t *pixels, int width, int height) {
-    GLuint texture = 0;
-    glGenTextures(1, &texture); CHECK_GL();
-    glBindTexture(GL_TEXTURE_2D, texture); CHECK_GL();
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    return texture;
+void teardown_gl_context(struct glx_handles *glx) {
+    glXMakeCurrent(glx->dpy, None, NULL);
+    glXDestroyContext(glx->dpy, glx->glc);
+    glx->glc = 0;
 }
 
-// assume gl es 2 (version 100) shader, and convert to gl es 3
-void fix_shader(char *dst, size_t dst_size, GLint major, char const *src) {
-    if (dst_size < strlen(src)+1) {
-        fprintf(stderr, "shader source buffer is too small, need at least: %ld\n", strlen(src)+1);
-        exit(1);
-    }
-    memcpy(dst, src, strlen(src)+1);
-    if (major == 2) return;
-    char *v = strstr(dst, "#version 100");
-    if (!v) exit(1);
-    v[strlen("#version ")] = '3';
-    v[strlen("#version 300 ")] = 'e';
-    v[strlen("#version 300 e")] = 's';
-    while ((v = strstr(dst, "texture2D"))) {
-        memcpy(v+2, v, strlen("texture"));
-        v[0] = ' ';
-        v[1] = ' ';
-    }
-    while ((v = strstr(dst, "varying"))) {
-        for (int i = 0; i < strlen("varying"); ++i) {
-            v[i] = ' ';
+void print_default_framebuffer(struct glx_handles *glx) {
+    GLint enc = 0;
+    GLenum gl_default_buffers[] = {GL_FRONT_LEFT, GL_BACK_LEFT, GL_FRONT_RIGHT, GL_BACK_RIGHT};
+    char const *gl_default_buffers_str[] = {"GL_FRONT_LEFT", "GL_BACK_LEFT", "GL_FRONT_RIGHT", "GL_BACK_RIGHT"};
+    GLenum gles_default_buffers[] = {glx->gl_major == 2 ? GL_COLOR_ATTACHMENT0 : GL_BACK};
+    char const *gles_default_buffers_str[] = {glx->gl_major == 2 ? "GL_COLOR_ATTACHMENT0" : "GL_BACK"};
+    int is_gl = glx->api == GL_API_OPENGL;
+    GLenum *default_buffers = is_gl ? gl_default_buffers : gles_default_buffers;
+    char const **default_buffers_str = is_gl ? gl_default_buffers_str : gles_default_buffers_str;
+    size_t num_default_buffers = is_gl ? 4 : 1;
+    for (int i = 0; i < num_default_buffers; ++i) {
+        // XXX: odd: this says linear even if it is sRGB
+        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &enc); CHECK_GL();
+        GLint redbits, greenbits, bluebits, alphabits;
+        if (glx->api == GL_API_GLES2 && glx->gl_major == 2) {
+            glGetIntegerv(GL_RED_BITS, &redbits);
+            glGetIntegerv(GL_GREEN_BITS, &greenbits);
+            glGetIntegerv(GL_BLUE_BITS, &bluebits);
+            glGetIntegerv(GL_ALPHA_BITS, &alphabits);
+        } else {
+            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_RED_SIZE, &redbits);
+            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_GREEN_SIZE, &greenbits);
+            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_BLUE_SIZE, &bluebits);
+            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE, &alphabits);
         }
-    }
-    //fprintf(stderr, "pre: \n%s\n", src);
-    //fprintf(stderr, "post: \n%s\n", dst);
-}
+        fprintf(stderr, "GL_FRAMEBUFFER %s RGBA bits: %d %d %d %d encoding is 0x%x => %s\n", default_buffers_str[i], redbits, greenbits, bluebits, alphabits, enc, enc == GL_SRGB ? "sRGB" : "not sRGB");
 
-void quadtest_setup(GLint major, struct quadtest *test, char const *vsh_es2, char const *fsh_es2) {
-    char vsh[1000];
-    major = 2;
-    fix_shader(vsh, 1000, major, vsh_es2);
-    char fsh[1000];
-    fix_shader(fsh, 1000, major, fsh_es2);
-    GLuint vert_shader = 0;
-    GLuint frag_shader = 0;
-    if (gl_compile_program_start(vsh, fsh, &test->program, &vert_shader, &frag_shader)) {
-        exit(1);
     }
-    test->position_index = 0;
-    test->uv_index = 1;
-    glBindAttribLocation(test->program, test->position_index, "position"); CHECK_GL();
-    glBindAttribLocation(test->program, test->uv_index, "uv"); CHECK_GL();
-    if (gl_compile_program_finish(test->program, vert_shader, frag_shader)) {
-        exit(1);
+    if (is_gl) {
+        GLboolean is_srgb;
+        glGetBooleanv(GL_FRAMEBUFFER_SRGB, &is_srgb);
+        fprintf(stderr, "glGetBooleanv(GL_FRAMEBUFFER_SRGB): %d\n", is_srgb);
     }
-    CHECK_GL();
-    test->texture_location = glGetUniformLocation(test->program, "tex"); CHECK_GL();
-    test->ramp_location = glGetUniformLocation(test->program, "ramp"); CHECK_GL();
-    test->offset_location = glGetUniformLocation(test->program, "offset"); CHECK_GL();
-    test->scale_location = glGetUniformLocation(test->program, "scale"); CHECK_GL();
-    glGenVertexArrays(1, &test->vertex_array); CHECK_GL();
-    glBindVertexArray(test->vertex_array); CHECK_GL();
-    glGenBuffers(1, &test->vertex_buffer); CHECK_GL();
-    glBindBuffer(GL_ARRAY_BUFFER, test->vertex_buffer); CHECK_GL();
-    size_t vertex_byte_count = 4 * sizeof (GLfloat);
-    size_t vertices_count = 6;
-    test->vertices_count = vertices_count;
-    // ab
-    // cd
-    // (acb bcd)
-    GLfloat vertices_xy_uv[] = {
-         1.f, -1.f,     1.f, 1.f,   // a
-        -1.f, -1.f,     0.f, 1.f,   // c
-         1.f,  1.f,     1.f, 0.f,   // b
-         1.f,  1.f,     1.f, 0.f,   // b
-        -1.f, -1.f,     0.f, 1.f,   // c
-        -1.f,  1.f,     0.f, 0.f    // d
-    };
-    glBufferData(GL_ARRAY_BUFFER, vertices_count * vertex_byte_count, vertices_xy_uv, GL_STATIC_DRAW); CHECK_GL();
-    glEnableVertexAttribArray(test->position_index); CHECK_GL();
-    glVertexAttribPointer(test->position_index, 2, GL_FLOAT, GL_FALSE, vertex_byte_count, 0); CHECK_GL();
-    glEnableVertexAttribArray(test->uv_index); CHECK_GL();
-    glVertexAttribPointer(test->uv_index, 2, GL_FLOAT, GL_FALSE, vertex_byte_count, (void *)(2*sizeof (GL_FLOAT))); CHECK_GL();
 }
 
-float linear_to_srgb(float linear) {
-    // https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_sRGB.txt
-    double cl = linear;
-    if (isnan(cl)) return 0.0;
-    if (cl > 1.0) return 1.0;
-    if (cl <= 0.0) return 0.0;
-    if (cl < 0.0031308) return 12.92 * cl;
-    if (cl < 1) return 1.055 * pow(cl, 0.41666) - 0.055;
-    return 1;
+int setup_gl_context_and_scene(enum gl_api api, int debug, int grid, struct glx_handles *glx, struct scene *scene) {
+    if (setup_gl_context(api, debug, glx)) return 1;
+    if (api == GL_API_OPENGL) {
+        // note: this does not exist in GL ES
+        // (is implicitly always true if gl context has sRGB framebuffer)
+        gl_state_enable(GL_FRAMEBUFFER_SRGB, 1);
+    }
+    print_default_framebuffer(glx);
+    if (CHECK_GL()) return 1;
+    XWindowAttributes gwa;
+    XGetWindowAttributes(glx->dpy, glx->win, &gwa);
+    return scene_setup(scene, api, glx->gl_major, gwa.width, gwa.height, grid);
 }
 
-float srgb_to_linear(float srgb) {
-    // see: https://en.wikipedia.org/wiki/SRGB
-    // https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_sRGB.txt
-    double cs = srgb;
-    if (cs < 0) cs = 0;
-    if (cs > 1) cs = 1;
-    if (cs <= 0.04045) return cs / 12.92;
-    return pow((cs + 0.055)/1.055, 2.4);
+static int max_diff(const uint8_t *a, const uint8_t *b, size_t n) {
+    int max = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int diff = abs(a[i] - b[i]);
+        if (diff > max) max = diff;
+    }
+    return max;
 }
 
-GLuint create_a_texture_srgb_ramp() {
-    // 1/255 is smallest value in sRGB format
-    // in linear, that value is lmin=1/255/12.92
-    // lmin must map to nonzero when we lookup
-    // lmin in the srgb ramp
-    // so we need 1/lmin = 3066 at minimum.
-    // due to rounding/precision, 3277 is minimum
-    // make that 4096
-    int range = 4096;
-    int width = range;
-    int height = 1;
-    uint8_t pixels[width*height];
-    for (int i = 0; i < range; ++i) {
-        float cl = (i+0.5)/(float)(range - 1);
-        float cs = linear_to_srgb(cl);
-        pixels[i] = cs*255.0;
+// if frame is not expected: how far off, per channel and perceptually,
+// with heat_dir also a heat map <heat_dir>/<case_name>.ppm (spaces as _)
+static int report_diff(const uint8_t *frame, const uint8_t *expected, int width, int height, const char *against, const char *case_name,
+        const char *heat_dir) {
+    uint8_t *heat = heat_dir ? malloc((size_t)width * height * 3) : 0;
+    struct frame_diff diff;
+    if ((heat_dir && !heat) || frame_diff(frame, expected, width, height, 0, heat, &diff)) {
+        free(heat);
+        return 1;
     }
-    for (int i = 0; i < range; ++i) {
-        fprintf(stderr, "linear: %d srgb: %d back to linear: %d\n", i, pixels[i], (uint8_t)(255.0*srgb_to_linear(pixels[i]/255.0)));
+    int failed = 0;
+    if (diff.differing) {
+        printf("  diff to %s: %ld pixels, %ld over one step, max rgba %d %d %d %d (linear %.4f %.4f %.4f %.4f), mean %.3f %.3f %.3f %.3f,"
+            " dE2000 max %.2f at %d,%d mean %.4f\n", against, diff.differing, diff.over_one_step,
+            diff.max_srgb[0], diff.max_srgb[1], diff.max_srgb[2], diff.max_srgb[3],
+            diff.max_linear[0], diff.max_linear[1], diff.max_linear[2], diff.max_linear[3],
+            diff.mean_srgb[0], diff.mean_srgb[1], diff.mean_srgb[2], diff.mean_srgb[3],
+            diff.max_delta_e, diff.max_x, diff.max_y, diff.mean_delta_e);
+        if (heat) {
+            char path[1024];
+            int n = snprintf(path, sizeof path, "%s/", heat_dir);
+            for (const char *c = case_name; *c && n < (int)sizeof path - 5; ++c) {
+                path[n++] = *c == ' ' ? '_' : *c;
+            }
+            snprintf(path + n, sizeof path - n, ".ppm");
+            failed = frame_diff_write_ppm(path, heat, width, height);
+        }
     }
-    return create_a_texture(pixels, width, height);
+    free(heat);
+    return failed;
 }
 
-GLuint create_srgb8_a8_texture_grey_pma(int width, int height, uint8_t grey, uint8_t alpha) {
-    size_t rowbytes = width*4;
-    uint8_t pixels[rowbytes*height];
-    for (int py = 0; py < height; ++py) {
-        uint8_t *pixel = pixels + py * rowbytes;
-        for (int px = 0; px < width; ++px) {
-            float cf = grey/255.0;
-            float a_srgb = linear_to_srgb(alpha);
-            pixel[0] = cf*a_srgb*255;
-            pixel[1] = cf*a_srgb*255;
-            pixel[2] = cf*a_srgb*255;
-            pixel[3] = alpha;
-            pixel += 4;
+// fragment (quad) and compute post-process of a width x height
+// srgb8_a8 target into an offscreen rgba8 one, so any size can be
+// measured whatever the window: GPU ms averaged over frames, and the
+// max difference of each compute output to the fragment one
+static int post_bench(struct scene *scene, struct gl_timer *timer, enum gl_api api, int width, int height) {
+    struct fborender *src = rt_pool_acquire(&scene->targets, GL_SRGB8_ALPHA8, width, height, 0);
+    struct fborender *dst = rt_pool_acquire(&scene->targets, GL_RGBA8, width, height, 0);
+    size_t frame_bytes = (size_t)width * height * 4;
+    uint8_t *reference = malloc(frame_bytes);
+    uint8_t *frame = malloc(frame_bytes);
+    if (!src || !dst || !reference || !frame) {
+        fprintf(stderr, "post_bench: no %dx%d targets\n", width, height);
+        if (src) rt_pool_release(&scene->targets, src);
+        if (dst) rt_pool_release(&scene->targets, dst);
+        free(reference);
+        free(frame);
+        return 1;
+    }
+    gl_state_bind_framebuffer(src->fbo);
+    glViewport(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT);
+    scene_draw(scene);
+    int frames = 10;
+    int failed = 0;
+    // -1: the quad, then each compute tile
+    for (int i = -1; i < COMPUTE_POST_TILES && scene->compute.supported; ++i) {
+        int render_failed = 0;
+        double gpu_ms = 0;
+        for (int f = 0; f < frames; ++f) {
+            gl_timer_begin(timer);
+            if (i < 0) {
+                GLfloat offset[] = {0, 0};
+                GLfloat scale[] = {1, 1};
+                GLfloat uv_scale[2];
+                fborender_uv_scale(src, uv_scale);
+                gl_state_bind_framebuffer(dst->fbo);
+                glClear(GL_COLOR_BUFFER_BIT);
+                quadtest_render(&scene->quad_postprocess, src->texture, scene->srgb_ramp, offset, scale, uv_scale);
+            } else {
+                render_failed = compute_post_render(&scene->compute, compute_post_tile(i), src, scene->srgb_ramp, dst);
+            }
+            gl_timer_end(timer);
+            gpu_ms += gl_timer_ms(timer);
+        }
+        gl_state_bind_framebuffer(dst->fbo);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, i < 0 ? reference : frame);
+        if (render_failed || CHECK_GL()) {
+            printf("%s post-process %dx%d %s: failed\n", gl_api_name(api), width, height, i < 0 ? "quad" : "compute");
+            failed = 1;
+            continue;
         }
+        if (i < 0) {
+            printf("%s post-process %dx%d quad: GPU %.3f ms\n", gl_api_name(api), width, height, gpu_ms / frames);
+            continue;
+        }
+        int max_diff = 0;
+        for (size_t j = 0; j < frame_bytes; ++j) {
+            int diff = abs(frame[j] - reference[j]);
+            if (diff > max_diff) max_diff = diff;
+        }
+        printf("%s post-process %dx%d compute %dx%d: GPU %.3f ms, max diff to quad: %d\n", gl_api_name(api), width, height,
+            compute_post_tile(i), compute_post_tile(i), gpu_ms / frames, max_diff);
     }
-    return create_srgb8_a8_texture(pixels, width, height);
-}
-
-void quadtest_render(struct quadtest *test, GLuint texture, GLuint ramp, GLfloat offset[2], GLfloat scale[2]) {
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glUseProgram(test->program); CHECK_GL();
-    glBindVertexArray(test->vertex_array); CHECK_GL();
-    glUniform2f(test->offset_location, offset[0], offset[1]); CHECK_GL();
-    glUniform2f(test->scale_location, scale[0], scale[1]); CHECK_GL();
-    glUniform1i(test->texture_location, 0); CHECK_GL();
-    glUniform1i(test->ramp_location, 1); CHECK_GL();
-    glActiveTexture(GL_TEXTURE0); CHECK_GL();
-    glBindTexture(GL_TEXTURE_2D, texture); CHECK_GL();
-    glActiveTexture(GL_TEXTURE1); CHECK_GL();
-    glBindTexture(GL_TEXTURE_2D, ramp); CHECK_GL();
-    // NOTE: texture must have pre-multiplied alpha
-    glBlendFunc(GL_ONE,       GL_ONE); CHECK_GL();
-    glBindBuffer(GL_ARRAY_BUFFER, test->vertex_buffer); CHECK_GL();
-    glDrawArrays(GL_TRIANGLES, 0, test->vertices_count); CHECK_GL();
+    gl_state_bind_framebuffer(0);
+    rt_pool_release(&scene->targets, src);
+    rt_pool_release(&scene->targets, dst);
+    free(reference);
+    free(frame);
+    return failed;
 }
 
-void quadtest_teardown(struct quadtest *test) {
-    glDeleteVertexArrays(1, &test->vertex_array);
-    glDeleteBuffers(1, &test->vertex_buffer);
-    glDeleteProgram(test->program);
-    glBindVertexArray(0); CHECK_GL();
+// renders every (api, fbo) case once in this process and prints the
+// center pixel, expect (1,1,1,255): the dark-grey quad
+// (with grid: the patch of grey 128 alpha 128), the direct frame is
+// compared with the CPU reference (ref_raster)
+// fbo runs once per intermediate format, each frame is compared with
+// the srgb8_a8 one (max abs difference over all channels) and timed
+// (render + full readback, so it includes waiting for the GPU)
+// then srgb8_a8 again with each compute post-process (GL 4.3), and with
+// each present strategy, compared with direct and timed over 20 frames,
+// and every blend input combination and texture decode checked
+// (blend_sweep, decode_check, GL 3.3, ES 3)
+// with golden: each frame of the first cases goes into the store and is
+// compared with the one stored for the case and driver before
+// a frame that differs from what it is compared with gets a frame_diff
+// report (and with heat_dir a heat map)
+int sweep(struct glx_handles *glx, int debug, int grid, struct golden_store *golden, const char *heat_dir) {
+    int failed = 0;
+    for (int api = 0; api < GL_API_COUNT; ++api) {
+        struct scene scene;
+        if (setup_gl_context_and_scene(api, debug, grid, glx, &scene)) {
+            fprintf(stderr, "sweep: no %s context\n", gl_api_name(api));
+            if (glx->glc) teardown_gl_context(glx);
+            failed = 1;
+            continue;
+        }
+        XWindowAttributes gwa;
+        XGetWindowAttributes(glx->dpy, glx->win, &gwa);
+        char driver[GOLDEN_DRIVER_SIZE];
+        snprintf(driver, sizeof driver, "%s / %s", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+        size_t frame_bytes = (size_t)gwa.width * gwa.height * 4;
+        uint8_t *frame = malloc(frame_bytes);
+        uint8_t *reference = malloc(frame_bytes);
+        uint8_t *direct = malloc(frame_bytes);
+        // the previous frame of a case whose golden changed
+        uint8_t *golden_frame = golden ? malloc(frame_bytes) : 0;
+        if (!frame || !reference || !direct || (golden && !golden_frame)) {
+            fprintf(stderr, "out of mem\n");
+            exit(1);
+        }
+        // case 0: direct, then fbo with each format, then compute (the
+        // fbo cases present with the quad, i.e. the ramp post-process)
+        int formats = fborender_format_count();
+        int computes = scene.compute.supported ? COMPUTE_POST_TILES : 0;
+        enum present_strategy strategy = scene.present_strategy;
+        scene.present_strategy = PRESENT_QUAD;
+        // the frames later ones are compared with were rendered
+        int have_direct = 0;
+        int have_quad = 0;
+        for (int i = 0; i < 1 + formats + computes; ++i) {
+            int use_fbo = i > 0;
+            if (use_fbo) scene.fbo_format = i <= formats ? fborender_format(i - 1) : GL_SRGB8_ALPHA8;
+            scene.compute_tile = i > formats ? compute_post_tile(i - 1 - formats) : 0;
+            if (use_fbo && !fborender_format_supported(api, scene.fbo_format)) {
+                printf("%s fbo %s: skipped, not color renderable here\n", gl_api_name(api), fborender_format_name(scene.fbo_format));
+                continue;
+            }
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (scene_render(&scene, use_fbo, gwa.width, gwa.height)) {
+                printf("%s %s%s", gl_api_name(api), use_fbo ? "fbo " : "direct", use_fbo ? fborender_format_name(scene.fbo_format) : "");
+                if (scene.compute_tile) printf(" compute %dx%d", scene.compute_tile, scene.compute_tile);
+                printf(": not renderable\n");
+                failed = 1;
+                continue;
+            }
+            glReadPixels(0, 0, gwa.width, gwa.height, GL_RGBA, GL_UNSIGNED_BYTE, frame);
+            double ms = gl_timer_elapsed_ms(&start);
+            if (CHECK_GL()) failed = 1;
+            uint8_t *center = frame + ((gwa.height / 2) * gwa.width + gwa.width / 2) * 4;
+            printf("%s %s%s", gl_api_name(api), use_fbo ? "fbo " : "direct", use_fbo ? fborender_format_name(scene.fbo_format) : "");
+            if (scene.compute_tile) printf(" compute %dx%d", scene.compute_tile, scene.compute_tile);
+            printf(" center: %d %d %d %d (%.2f ms)", center[0], center[1], center[2], center[3], ms);
+            // e.g. "gl quad direct", "gles2 grid srgb8_a8 compute 8"
+            char case_name[GOLDEN_CASE_SIZE];
+            int n = snprintf(case_name, sizeof case_name, "%s %s %s", gl_api_name(api), grid ? "grid" : "quad",
+                use_fbo ? fborender_format_name(scene.fbo_format) : "direct");
+            if (scene.compute_tile) snprintf(case_name + n, sizeof case_name - n, " compute %d", scene.compute_tile);
+            // a changed golden of the same size is diffed with this frame
+            int have_golden = 0;
+            if (golden) {
+                enum golden_status status;
+                uint64_t previous = 0;
+                int previous_width = 0, previous_height = 0;
+                golden_store_lookup(golden, case_name, driver, &previous, &previous_width, &previous_height);
+                if (golden_store_put(golden, case_name, driver, frame, gwa.width, gwa.height, &status)) {
+                    failed = 1;
+                } else if (status == GOLDEN_CHANGED) {
+                    printf(" golden: changed (was %016" PRIx64 ")", previous);
+                    if (previous_width != gwa.width || previous_height != gwa.height) {
+                        printf(", was %dx%d", previous_width, previous_height);
+                    } else if (golden_store_load(golden, previous, golden_frame, gwa.width, gwa.height)) {
+                        failed = 1;
+                    } else {
+                        have_golden = 1;
+                    }
+                } else {
+                    printf(" golden: %s", status == GOLDEN_NEW ? "new" : "same");
+                }
+            }
+            const uint8_t *expected = 0;
+            if (i == 0) {
+                memcpy(direct, frame, frame_bytes);
+                have_direct = 1;
+                // and what the direct frame should be, from the CPU
+                struct ref_raster raster;
+                ref_raster_setup(&raster, gwa.width, gwa.height, 0);
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                if (scene_reference(&scene, &raster, reference)) {
+                    failed = 1;
+                } else {
+                    printf(" max diff to reference: %d (%d threads, %.2f ms)", max_diff(frame, reference, frame_bytes),
+                        raster.threads, gl_timer_elapsed_ms(&start));
+                    expected = reference;
+                }
+                ref_raster_teardown(&raster);
+            } else if (i == 1) {
+                memcpy(reference, frame, frame_bytes);
+                have_quad = 1;
+            } else if (!have_quad) {
+                printf(" no srgb8_a8 frame to compare with");
+                failed = 1;
+            } else {
+                printf(" max diff to srgb8_a8: %d", max_diff(frame, reference, frame_bytes));
+                expected = reference;
+            }
+            printf("\n");
+            if (expected && report_diff(frame, expected, gwa.width, gwa.height, i == 0 ? "reference" : "srgb8_a8", case_name, heat_dir)) {
+                failed = 1;
+            }
+            if (have_golden) {
+                char golden_case[GOLDEN_CASE_SIZE + 8];
+                snprintf(golden_case, sizeof golden_case, "%s golden", case_name);
+                if (report_diff(frame, golden_frame, gwa.width, gwa.height, "golden", golden_case, heat_dir)) failed = 1;
+            }
+        }
+        scene.compute_tile = 0;
+        scene.fbo_format = GL_SRGB8_ALPHA8;
+        struct gl_timer timer;
+        gl_timer_setup(&timer, api);
+        // blit should give the direct frame, copy the quad one
+        for (int i = 0; i < PRESENT_STRATEGY_COUNT; ++i) {
+            if (!scene.present.supported[i]) continue;
+            scene.present_strategy = i;
+            if (scene_render(&scene, 1, gwa.width, gwa.height)) {
+                printf("%s present %s: failed\n", gl_api_name(api), present_strategy_name(i));
+                failed = 1;
+                continue;
+            }
+            glReadPixels(0, 0, gwa.width, gwa.height, GL_RGBA, GL_UNSIGNED_BYTE, frame);
+            int frames = 20;
+            double gpu_ms = 0;
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int f = 0; f < frames; ++f) {
+                gl_timer_begin(&timer);
+                scene_render(&scene, 1, gwa.width, gwa.height);
+                gl_timer_end(&timer);
+                gpu_ms += gl_timer_ms(&timer);
+            }
+            printf("%s present %s%s: %.3f ms/frame, GPU %.3f ms/frame", gl_api_name(api), present_strategy_name(i),
+                i == (int)strategy ? " (auto)" : "", gl_timer_elapsed_ms(&start) / frames, timer.supported ? gpu_ms / frames : -1);
+            // a missing baseline already failed the sweep above
+            if (have_direct) printf(", max diff to direct: %d", max_diff(frame, direct, frame_bytes));
+            if (have_quad) printf(", max diff to quad: %d", max_diff(frame, reference, frame_bytes));
+            printf("\n");
+        }
+        scene.present_strategy = strategy;
+        free(frame);
+        free(reference);
+        free(direct);
+        free(golden_frame);
+        int sizes[][2] = {{600, 600}, {1920, 1080}, {3840, 2160}};
+        for (int i = 0; i < 3 && scene.compute.supported; ++i) {
+            if (post_bench(&scene, &timer, api, sizes[i][0], sizes[i][1])) failed = 1;
+        }
+        // the CPU resolve needs the sample positions
+        int max_samples = msaa_has_sample_positions(api) ? msaa_max_samples() : 0;
+        for (int samples = 2; samples <= 8 && samples <= max_samples; samples *= 2) {
+            struct msaa_check check;
+            if (msaa_check(&scene.targets, &scene.quad_darkgrey, &timer, samples, gwa.width, gwa.height, &check)) {
+                failed = 1;
+                continue;
+            }
+            // a correct resolve averages in linear, max diff 0 or 1
+            printf("%s msaa %dx (%d samples) resolve: %.3f ms, %d edge pixels, max diff to linear resolve: %d, to sRGB resolve: %d\n",
+                gl_api_name(api), samples, check.samples, check.resolve_ms, check.edge_pixels, check.max_diff_linear, check.max_diff_srgb);
+        }
+        // every sRGB8 src, dst, alpha through each blend function, against
+        // the linear blend computed on the CPU: off by one is rounding
+        struct blend_sweep blend;
+        if (!blend_sweep_setup(&blend, api)) {
+            for (int func = 0; func < BLEND_SWEEP_FUNCS; ++func) {
+                struct blend_sweep_result result;
+                if (blend_sweep_run(&blend, &scene.targets, func, &result)) {
+                    failed = 1;
+                    continue;
+                }
+                // more than rounding
+                if (result.wrong) failed = 1;
+                printf("%s blend %s: exact %ld, off by one %ld, worse %ld, max diff %d at src %d dst %d alpha %d, GPU %.0f ms, CPU reference %.0f ms\n",
+                    gl_api_name(api), blend_sweep_func_name(func), result.exact, result.off_by_one, result.wrong, result.max_diff,
+                    result.worst_src, result.worst_dst, result.worst_alpha, result.gpu_ms, result.cpu_ms);
+            }
+        }
+        blend_sweep_teardown(&blend);
+        // every sRGB8 code through the texture unit, into a float target
+        struct decode_check decode;
+        if (!decode_check_setup(&decode, api)) {
+            struct decode_check_result results[DECODE_CHECK_PATHS];
+            int decode_failed = decode_check_run(&decode, &scene.targets, results);
+            if (decode_failed) failed = 1;
+            for (int path = 0; path < DECODE_CHECK_PATHS && !decode_failed; ++path) {
+                // alpha is not decoded, it is off when nearer another code
+                if (results[path].off || results[path].max_error_alpha > 0.5 / 255) failed = 1;
+                printf("%s decode %s: max error %.2e at code %d, alpha %.2e, codes off: %d\n", gl_api_name(api), decode_check_path_name(path),
+                    results[path].max_error, results[path].worst_code, results[path].max_error_alpha, results[path].off);
+            }
+        }
+        decode_check_teardown(&decode);
+        // same fbo frame with and without invalidation, averaged
+        int can_invalidate = scene.invalidate;
+        for (int invalidate = 0; invalidate <= can_invalidate; ++invalidate) {
+            scene.invalidate = invalidate;
+            int frames = 20;
+            double gpu_ms = 0;
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int frame = 0; frame < frames; ++frame) {
+                gl_timer_begin(&timer);
+                scene_render(&scene, 1, gwa.width, gwa.height);
+                gl_timer_end(&timer);
+                gpu_ms += gl_timer_ms(&timer);
+            }
+            printf("%s fbo %s invalidate: %.3f ms/frame, GPU %.3f ms/frame\n", gl_api_name(api), invalidate ? "with" : "without",
+                gl_timer_elapsed_ms(&start) / frames, timer.supported ? gpu_ms / frames : -1);
+        }
+        gl_timer_teardown(&timer);
+        printf("%s render targets created: %lu, reused: %lu\n", gl_api_name(api), scene.targets.created, scene.targets.reused);
+        unsigned long issued, skipped;
+        gl_state_stats(&issued, &skipped);
+        printf("%s state calls issued: %lu, filtered as redundant: %lu\n", gl_api_name(api), issued, skipped);
+        scene_teardown(&scene);
+        teardown_gl_context(glx);
+    }
+    return failed;
 }
 
-struct fborender {
-    GLuint texture;
-    GLuint fbo;
-    int width, height;
-};
-
-int fborender_setup(struct fborender *test, int width, int height) {
-    GLuint texture = create_srgb8_a8_texture(0, width, height);
-    GLuint fb;
-    glGenFramebuffers(1, &fb);
-    glBindFramebuffer(GL_FRAMEBUFFER, fb);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        fprintf(stderr, "failed create framebuffer, not complete?\n");
-        return 1;
+int has_arg(int argc, char *argv[], char const *arg) {
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], arg)) return 1;
     }
-    test->texture = texture;
-    test->fbo = fb;
     return 0;
 }
 
-
-void fborender_resize(struct fborender *test, int width, int height) {
-    if (test->width == width && test->height == height) return;
-    glBindTexture(GL_TEXTURE_2D, test->texture); CHECK_GL();
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0); CHECK_GL();
-}
-
-void fborender_teardown(struct fborender *test) {
-    glDeleteTextures(1, &test->texture);
-    glDeleteRenderbuffers(1, &test->fbo);
-}
-
 int main(int argc, char *argv[]) {
-    struct glx_handles glx;
-    if (setup_gl_context(600, 600, &glx)) return 1;
-#if USE_OPENGL
-    // note: this does not exist in GL ES
-    // (is implicitly always true if gl context has sRGB framebuffer)
-    glEnable(GL_FRAMEBUFFER_SRGB);
-#endif
-    GLint enc = 0;
-#if USE_OPENGL
-    GLenum default_buffers[] = {GL_FRONT_LEFT, GL_BACK_LEFT, GL_FRONT_RIGHT, GL_BACK_RIGHT};
-    char *default_buffers_str[] = {"GL_FRONT_LEFT", "GL_BACK_LEFT", "GL_FRONT_RIGHT", "GL_BACK_RIGHT"};
-#else
-    GLenum default_buffer = glx.gl_major == 2 ? GL_COLOR_ATTACHMENT0 : GL_BACK;
-    char const *default_buffer_str = glx.gl_major == 2 ? "GL_COLOR_ATTACHMENT0" : "GL_BACK";
-    GLenum default_buffers[] = {default_buffer};
-    char const *default_buffers_str[] = {default_buffer_str};
-#endif
-    size_t num_default_buffers = sizeof default_buffers / sizeof default_buffers[0];
-    for (int i = 0; i < num_default_buffers; ++i) {
-        // XXX: odd: this says linear even if it is sRGB
-        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &enc); CHECK_GL();
-        GLint redbits, greenbits, bluebits, alphabits;
-#if USE_GLES2
-        glGetIntegerv(GL_RED_BITS, &redbits);
-        glGetIntegerv(GL_GREEN_BITS, &greenbits);
-        glGetIntegerv(GL_BLUE_BITS, &bluebits);
-        glGetIntegerv(GL_ALPHA_BITS, &alphabits);
-#else
-        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_RED_SIZE, &redbits);
-        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_GREEN_SIZE, &greenbits);
-        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_BLUE_SIZE, &bluebits);
-        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, default_buffers[i], GL_FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE, &alphabits);
-#endif
-        fprintf(stderr, "GL_FRAMEBUFFER %s RGBA bits: %d %d %d %d encoding is 0x%x => %s\n", default_buffers_str[i], redbits, greenbits, bluebits, alphabits, enc, enc == GL_SRGB ? "sRGB" : "not sRGB");
-
+    // gles2: GL ES 2 context instead of GL 4.6
+    enum gl_api api = has_arg(argc, argv, "gles2") ? GL_API_GLES2 : GL_API_OPENGL;
+    // debug: debug context with asynchronous KHR_debug output
+    // debug_sync: same, but messages are generated synchronously
+    int debug = has_arg(argc, argv, "debug_sync") ? 2 : has_arg(argc, argv, "debug");
+    int use_fbo = has_arg(argc, argv, "fbo");
+    // grid: 256x256 patches, one per grey/alpha pair, in one draw
+    int grid = has_arg(argc, argv, "grid");
+    // format=<name>: intermediate fbo format, e.g. format=rgba16f
+    // msaa=<n>: render the fbo with n samples and resolve it
+    // noinvalidate: keep dead framebuffer contents (for comparison)
+    // compute=<n>: fbo post-process as a compute pass in n x n tiles (8, 16)
+    // present=<quad|copy|blit>: how the fbo gets to the window, instead of
+    // the one picked at startup
+    // golden=<dir>: with sweep, keep the frames in a golden store there
+    // heat=<dir>: with sweep, a CIEDE2000 heat map there per differing frame
+    GLenum fbo_format = GL_SRGB8_ALPHA8;
+    int fbo_samples = 0;
+    int compute_tile = 0;
+    int present_strategy = -1;
+    const char *golden_dir = 0;
+    const char *heat_dir = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strncmp(argv[i], "golden=", strlen("golden="))) golden_dir = argv[i] + strlen("golden=");
+        if (!strncmp(argv[i], "heat=", strlen("heat="))) heat_dir = argv[i] + strlen("heat=");
+        if (!strncmp(argv[i], "present=", strlen("present="))) {
+            present_strategy = present_strategy_by_name(argv[i] + strlen("present="));
+            if (present_strategy < 0) {
+                fprintf(stderr, "unknown present strategy: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        if (!strncmp(argv[i], "msaa=", strlen("msaa="))) fbo_samples = atoi(argv[i] + strlen("msaa="));
+        if (!strncmp(argv[i], "compute=", strlen("compute="))) compute_tile = atoi(argv[i] + strlen("compute="));
+        if (strncmp(argv[i], "format=", strlen("format="))) continue;
+        fbo_format = fborender_format_by_name(argv[i] + strlen("format="));
+        if (!fbo_format) {
+            fprintf(stderr, "unknown format: %s\n", argv[i]);
+            return 1;
+        }
     }
-    if (CHECK_GL()) return 1;
-#if USE_OPENGL
-        GLboolean is_srgb;
-        glGetBooleanv(GL_FRAMEBUFFER_SRGB, &is_srgb);
-        fprintf(stderr, "glGetBooleanv(GL_FRAMEBUFFER_SRGB): %d\n", is_srgb);
-#endif
-    // load a texture in sRGB with the lowest value possible
-    // (i.e. = 1, which is 0 in linear)
-    GLuint darkgrey_texture = create_srgb8_a8_texture_grey_pma(4, 4, 1, 255);
-    if (!darkgrey_texture) {
-        exit(1);
+    struct glx_handles glx;
+    if (setup_window(600, 600, &glx)) return 1;
+    if (has_arg(argc, argv, "sweep")) {
+        // the window must be exposed for its pixels to be defined
+        XEvent xev;
+        do {
+            XNextEvent(glx.dpy, &xev);
+        } while (xev.type != Expose);
+        struct golden_store golden;
+        if (golden_dir && golden_store_open(&golden, golden_dir)) return 1;
+        int failed = sweep(&glx, debug, grid, golden_dir ? &golden : 0, heat_dir);
+        if (golden_dir) {
+            printf("golden store %s: %lu frames, %lu new objects (%lu KiB), %lu deduplicated\n", golden_dir, golden.puts, golden.written,
+                golden.written_bytes / 1024, golden.deduplicated);
+            if (golden_store_close(&golden)) failed = 1;
+        }
+        teardown_window(&glx);
+        gl_debug_teardown();
+        return failed;
     }
-    // for fbo rendering when we don't have sRGB framebuffer, we
-    // take linear data to sRGB via a ramp_texture
-    GLuint srgb_ramp = create_a_texture_srgb_ramp();
-    if (!srgb_ramp) {
-        exit(1);
+    struct scene scene;
+    if (setup_gl_context_and_scene(api, debug, grid, &glx, &scene)) return 1;
+    scene.fbo_format = fbo_format;
+    scene.fbo_samples = fbo_samples;
+    if (compute_tile && !scene.compute.supported) {
+        fprintf(stderr, "no compute post-process here, using the quad\n");
+    } else {
+        scene.compute_tile = compute_tile;
     }
-    struct fborender fborender;
-    XWindowAttributes gwa;
-    XGetWindowAttributes(glx.dpy, glx.win, &gwa);
-    if (fborender_setup(&fborender, gwa.width, gwa.height)) {
-        exit(1);
+    if (has_arg(argc, argv, "noinvalidate")) scene.invalidate = 0;
+    if (present_strategy >= 0) {
+        if (!scene.present.supported[present_strategy]) {
+            fprintf(stderr, "present %s not supported here\n", present_strategy_name(present_strategy));
+            return 1;
+        }
+        scene.present_strategy = present_strategy;
     }
-    if (CHECK_GL()) return 1;
-    int use_fbo = argc > 1;
-    struct quadtest quad_darkgrey;
-    quadtest_setup(glx.gl_major, &quad_darkgrey,
-        " #version 100 //\n"
-        " varying in vec2 position;"
-        " uniform vec2 offset;"
-        " uniform vec2 scale;"
-        " in vec2 uv;"
-        " varying out lowp vec2 f_uv;"
-        " void main() {"
-        "     vec4 pos;"
-        "     pos.xy = position * scale + offset;"
-        "     pos.z = 0.0;"
-        "     pos.w = 1.0;"
-        "     gl_Position = pos;"
-        "     f_uv = uv;"
-        " }",
-        " #version 100 //\n"
-        " uniform lowp sampler2D tex;"
-        " in lowp vec2 f_uv;"
-        " varying out lowp vec4 fragmentColor;"
-        " precision mediump float;"
-        " void main() {"
-        "     vec4 tx = texture2D(tex, f_uv);" // GLES3: texture
-        // NOTE: texture is assumed to be premultiplied alpha
-        "     fragmentColor = tx;"
-        " }");
-    struct quadtest quad_postprocess;
-    quadtest_setup(glx.gl_major, &quad_postprocess,
-        " #version 100 //\n"
-        " varying in vec2 position;"
-        " uniform vec2 offset;"
-        " uniform vec2 scale;"
-        " in vec2 uv;"
-        " varying out lowp vec2 f_uv;"
-        " void main() {"
-        "     vec4 pos;"
-        "     pos.xy = position * scale + offset;"
-        "     pos.z = 0.0;"
-        "     pos.w = 1.0;"
-        "     gl_Position = pos;"
-        "     f_uv = uv;"
-        " }",
-        " #version 100 //\n"
-        " uniform highp sampler2D tex;"
-        " uniform lowp sampler2D ramp;"
-        " in lowp vec2 f_uv;"
-        " varying out lowp vec4 fragmentColor;"
-        " precision mediump float;"
-        " void main() {"
-        "     vec4 tx = texture2D(tex, f_uv);" // GLES3: texture
-        // NOTE: texture is assumed to be premultiplied alpha
-        "     vec4 srgb_a = vec4(texture2D(ramp, vec2(tx.r, 0.0)).a,"
-        "                        texture2D(ramp, vec2(tx.g, 0.0)).a,"
-        "                        texture2D(ramp, vec2(tx.b, 0.0)).a,"
-        "                        tx.a);"
-        // calculation instead of ramp
-        //"     float cs;"
-        //"     float cl = tx.r;"
-        //"     if (cl < 0.0031308) cs = 12.92 * cl;"
-        //"     else cs = 1.055 * pow(cl, 0.41666) - 0.055;"
-        //"     srgb_a.rgb = vec3(cs,cs,cs);"
-        "     fragmentColor = srgb_a;"
-        " }");
     while (1) {
         XEvent xev;
         XNextEvent(glx.dpy, &xev);
         if(xev.type == Expose) {
             XWindowAttributes gwa;
             XGetWindowAttributes(glx.dpy, glx.win, &gwa);
-            if (use_fbo) {
-                fborender_resize(&fborender, gwa.width, gwa.height);
-                glBindFramebuffer(GL_FRAMEBUFFER, fborender.fbo);
-            } else {
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            }
             fprintf(stderr, "w: %d h:%d\n", gwa.width, gwa.height);
-            glViewport(0, 0, gwa.width, gwa.height);
-            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            GLfloat offset[] = {0, 0};
-            GLfloat scale[] = {0.5, 0.5};
-            quadtest_render(&quad_darkgrey, darkgrey_texture, 0, offset, scale);
-            if (use_fbo) {
-                GLfloat offset[] = {0, 0};
-                GLfloat scale[] = {1, 1};
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                quadtest_render(&quad_postprocess, fborender.texture, srgb_ramp, offset, scale);
-            }
+            scene_render(&scene, use_fbo, gwa.width, gwa.height);
             glXSwapBuffers(glx.dpy, glx.win);
         } else if(xev.type == KeyPress) {
-            glXMakeCurrent(glx.dpy, None, NULL);
-            glXDestroyContext(glx.dpy, glx.glc);
-            XDestroyWindow(glx.dpy, glx.win);
-            XCloseDisplay(glx.dpy);
+            scene_teardown(&scene);
+            teardown_gl_context(&glx);
+            teardown_window(&glx);
+            gl_debug_teardown();
             exit(0);
         }
     }
-    fborender_teardown(&fborender);
-    quadtest_teardown(&quad_darkgrey);
-    quadtest_teardown(&quad_postprocess);
-    glDeleteTextures(1, &darkgrey_texture); CHECK_GL();
     return 0;
 }
-
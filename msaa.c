@@ -0,0 +1,114 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "msaa.h"
+#include "gl_error.h"
+#include "gl_state.h"
+#include "srgb.h"
+
+int msaa_max_samples(void) {
+    if (GLVersion.major < 3 || !glBlitFramebuffer || !glRenderbufferStorageMultisample) return 0;
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples); CHECK_GL();
+    return max_samples;
+}
+
+int msaa_has_sample_positions(enum gl_api api) {
+    int major = GLVersion.major, minor = GLVersion.minor;
+    if (api == GL_API_OPENGL) {
+        if (major < 3 || (major == 3 && minor < 2)) return 0;
+    } else if (major < 3 || (major == 3 && minor < 1)) {
+        return 0;
+    }
+    return glGetMultisamplefv != 0;
+}
+
+void msaa_resolve(struct fborender *src, struct fborender *dst) {
+    gl_state_bind_framebuffers(src->fbo, dst->fbo);
+    glBlitFramebuffer(0, 0, src->width, src->height, 0, 0, dst->width, dst->height, GL_COLOR_BUFFER_BIT, GL_NEAREST); CHECK_GL();
+}
+
+// the quad edges, in window coordinates, away from any sample position
+static void quad_rect(int width, int height, float rect[4]) {
+    rect[0] = (int)(width * 0.25f) + 0.3f;
+    rect[1] = (int)(height * 0.25f) + 0.3f;
+    rect[2] = (int)(width * 0.75f) + 0.7f;
+    rect[3] = (int)(height * 0.75f) + 0.7f;
+}
+
+int msaa_check(struct rt_pool *pool, struct quadtest *quad, struct gl_timer *timer, int samples, int width, int height, struct msaa_check *out) {
+    if (!glGetMultisamplefv) {
+        fprintf(stderr, "msaa_check: no glGetMultisamplefv\n");
+        return 1;
+    }
+    // mid grey, where linear and sRGB averages are far apart
+    uint8_t grey = 128;
+    GLuint texture = create_srgb8_a8_texture_grey_pma(4, 4, grey, 255);
+    struct fborender *ms = rt_pool_acquire(pool, GL_SRGB8_ALPHA8, width, height, samples);
+    struct fborender *resolved = rt_pool_acquire(pool, GL_SRGB8_ALPHA8, width, height, 0);
+    uint8_t *pixels = malloc((size_t)width * height * 4);
+    if (!texture || !ms || !resolved || !pixels) {
+        fprintf(stderr, "msaa_check: setup failed for %d samples\n", samples);
+        if (ms) rt_pool_release(pool, ms);
+        if (resolved) rt_pool_release(pool, resolved);
+        if (texture) gl_state_delete_textures(1, &texture);
+        free(pixels);
+        return 1;
+    }
+    // the implementation may pick more samples than asked for
+    GLint actual_samples = 0;
+    gl_state_bind_framebuffer(ms->fbo);
+    glGetIntegerv(GL_SAMPLES, &actual_samples); CHECK_GL();
+    GLfloat positions[2 * 32];
+    if (actual_samples > 32) actual_samples = 32;
+    for (int i = 0; i < actual_samples; ++i) {
+        glGetMultisamplefv(GL_SAMPLE_POSITION, i, positions + 2 * i); CHECK_GL();
+    }
+    float rect[4];
+    quad_rect(width, height, rect);
+    GLfloat offset[] = {(rect[0] + rect[2]) / width - 1.f, (rect[1] + rect[3]) / height - 1.f};
+    GLfloat scale[] = {(rect[2] - rect[0]) / width, (rect[3] - rect[1]) / height};
+    GLfloat uv_scale[] = {1, 1};
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    quadtest_render(quad, texture, 0, offset, scale, uv_scale);
+    gl_timer_begin(timer);
+    msaa_resolve(ms, resolved);
+    gl_timer_end(timer);
+    gl_state_bind_framebuffer(resolved->fbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
+    out->samples = actual_samples;
+    out->resolve_ms = gl_timer_ms(timer);
+    out->max_diff_linear = 0;
+    out->max_diff_srgb = 0;
+    out->edge_pixels = 0;
+    float linear = srgb_to_linear(grey / 255.f);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int covered = 0;
+            for (int i = 0; i < actual_samples; ++i) {
+                float sx = x + positions[2 * i];
+                float sy = y + positions[2 * i + 1];
+                covered += sx >= rect[0] && sx < rect[2] && sy >= rect[1] && sy < rect[3];
+            }
+            if (covered && covered < actual_samples) ++out->edge_pixels;
+            int expect_linear = lrintf(linear_to_srgb(linear * covered / actual_samples) * 255.f);
+            int expect_srgb = lrintf(grey * covered / (float)actual_samples);
+            uint8_t *pixel = pixels + (y * width + x) * 4;
+            for (int c = 0; c < 3; ++c) {
+                int diff_linear = abs(pixel[c] - expect_linear);
+                int diff_srgb = abs(pixel[c] - expect_srgb);
+                if (diff_linear > out->max_diff_linear) out->max_diff_linear = diff_linear;
+                if (diff_srgb > out->max_diff_srgb) out->max_diff_srgb = diff_srgb;
+            }
+        }
+    }
+    free(pixels);
+    rt_pool_release(pool, ms);
+    rt_pool_release(pool, resolved);
+    gl_state_delete_textures(1, &texture);
+    if (CHECK_GL_STAGE("msaa_check")) return 1;
+    return 0;
+}
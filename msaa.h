@@ -0,0 +1,40 @@
+//  MIT license
+#ifndef MSAA_H
+#define MSAA_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+#include "gl_timer.h"
+#include "fborender.h"
+#include "rt_pool.h"
+#include "quadtest.h"
+
+// GL_MAX_SAMPLES, 0 without multisampled renderbuffers and blit
+// (GL 3.0, GL ES 3.0)
+int msaa_max_samples(void);
+// glGetMultisamplefv, which msaa_check needs (GL 3.2, GL ES 3.1)
+int msaa_has_sample_positions(enum gl_api api);
+// glBlitFramebuffer of the rendered part of src (multisampled) into dst
+void msaa_resolve(struct fborender *src, struct fborender *dst);
+
+struct msaa_check {
+    int samples;
+    // GPU time of the resolve blit, -1 if unknown
+    double resolve_ms;
+    // largest difference of the resolved sRGB pixels to the reference
+    // averaged in linear space (correct), and to one averaged on the
+    // sRGB encoded values (what a resolve that ignores sRGB gives)
+    int max_diff_linear;
+    int max_diff_srgb;
+    // pixels partially covered, i.e. where the resolve matters
+    int edge_pixels;
+};
+
+// Draws a grey quad with edges between samples into a multisampled
+// GL_SRGB8_ALPHA8 target, resolves it and compares with a CPU resolve
+// from the sample positions of the target (glGetMultisamplefv, see
+// msaa_has_sample_positions).
+// quad: a quadtest that draws its texture as is.
+int msaa_check(struct rt_pool *pool, struct quadtest *quad, struct gl_timer *timer, int samples, int width, int height, struct msaa_check *out);
+
+#endif
@@ -0,0 +1,133 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pattern_atlas.h"
+#include "gl_error.h"
+#include "gl_state.h"
+#include "srgb.h"
+
+static int has_texture_arrays(enum gl_api api) {
+    // glTexStorage3D: core since GL 4.2 and GL ES 3.0
+    if (api == GL_API_OPENGL) return GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2);
+    return GLVersion.major >= 3;
+}
+
+static int page_width(struct pattern_atlas *atlas) {
+    return atlas->columns * atlas->pattern_width;
+}
+
+static int page_height(struct pattern_atlas *atlas) {
+    return atlas->rows * atlas->pattern_height;
+}
+
+int pattern_atlas_setup(struct pattern_atlas *atlas, enum gl_api api, int pattern_width, int pattern_height, int capacity) {
+    GLint max_size = 0;
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size); CHECK_GL();
+    atlas->target = GL_TEXTURE_2D;
+    if (has_texture_arrays(api)) {
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers); CHECK_GL();
+        int columns = PATTERN_ATLAS_PAGE_SIZE / pattern_width;
+        int rows = PATTERN_ATLAS_PAGE_SIZE / pattern_height;
+        if (columns > 0 && rows > 0) {
+            if (columns > capacity) columns = capacity;
+            if (rows > (capacity + columns - 1) / columns) rows = (capacity + columns - 1) / columns;
+            int pages = (capacity + columns * rows - 1) / (columns * rows);
+            if (pages <= max_layers) {
+                atlas->target = GL_TEXTURE_2D_ARRAY;
+                atlas->columns = columns;
+                atlas->rows = rows;
+                atlas->pages = pages;
+            }
+        }
+    }
+    if (atlas->target == GL_TEXTURE_2D) {
+        // one page, about square
+        atlas->columns = (int)ceil(sqrt(capacity));
+        atlas->rows = (capacity + atlas->columns - 1) / atlas->columns;
+        atlas->pages = 1;
+        if (atlas->columns * pattern_width > max_size || atlas->rows * pattern_height > max_size) {
+            fprintf(stderr, "pattern_atlas: %d patterns of %dx%d do not fit in %dx%d\n", capacity, pattern_width, pattern_height, max_size, max_size);
+            return 1;
+        }
+    }
+    atlas->pattern_width = pattern_width;
+    atlas->pattern_height = pattern_height;
+    atlas->capacity = capacity;
+    atlas->count = 0;
+    atlas->uploaded = 0;
+    size_t page_bytes = (size_t)page_width(atlas) * page_height(atlas) * 4;
+    atlas->pixels = calloc(atlas->pages, page_bytes);
+    if (!atlas->pixels) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    glGenTextures(1, &atlas->texture); CHECK_GL();
+    gl_state_bind_texture(0, atlas->target, atlas->texture); CHECK_GL();
+    if (atlas->target == GL_TEXTURE_2D_ARRAY) {
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_SRGB8_ALPHA8, page_width(atlas), page_height(atlas), atlas->pages); CHECK_GL();
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, page_width(atlas), page_height(atlas), 0, GL_RGBA, GL_UNSIGNED_BYTE, 0); CHECK_GL();
+    }
+    glTexParameteri(atlas->target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(atlas->target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(atlas->target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(atlas->target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    fprintf(stderr, "pattern_atlas: %d patterns of %dx%d, %s %dx%d x %d\n", capacity, pattern_width, pattern_height,
+        atlas->target == GL_TEXTURE_2D_ARRAY ? "GL_TEXTURE_2D_ARRAY" : "GL_TEXTURE_2D", page_width(atlas), page_height(atlas), atlas->pages);
+    if (CHECK_GL_STAGE("pattern_atlas_setup")) return 1;
+    return 0;
+}
+
+int pattern_atlas_add(struct pattern_atlas *atlas, const uint8_t *pixels) {
+    if (atlas->count == atlas->capacity) return -1;
+    int layer = atlas->count++;
+    int per_page = atlas->columns * atlas->rows;
+    int page = layer / per_page;
+    int tile = layer % per_page;
+    size_t rowbytes = (size_t)page_width(atlas) * 4;
+    size_t pattern_rowbytes = (size_t)atlas->pattern_width * 4;
+    uint8_t *dst = atlas->pixels + page * rowbytes * page_height(atlas)
+        + (tile / atlas->columns) * atlas->pattern_height * rowbytes
+        + (tile % atlas->columns) * pattern_rowbytes;
+    for (int y = 0; y < atlas->pattern_height; ++y) {
+        memcpy(dst + y * rowbytes, pixels + y * pattern_rowbytes, pattern_rowbytes);
+    }
+    return layer;
+}
+
+int pattern_atlas_add_grey_pma(struct pattern_atlas *atlas, uint8_t grey, uint8_t alpha) {
+    size_t count = (size_t)atlas->pattern_width * atlas->pattern_height;
+    uint8_t pixels[count * 4];
+    for (size_t i = 0; i < count; ++i) {
+        srgb_grey_pma(grey, alpha, pixels + i * 4);
+    }
+    return pattern_atlas_add(atlas, pixels);
+}
+
+int pattern_atlas_upload(struct pattern_atlas *atlas) {
+    if (atlas->uploaded == atlas->count) return 0;
+    int per_page = atlas->columns * atlas->rows;
+    int first_page = atlas->uploaded / per_page;
+    int end_page = (atlas->count + per_page - 1) / per_page;
+    gl_state_bind_texture(0, atlas->target, atlas->texture); CHECK_GL();
+    if (atlas->target == GL_TEXTURE_2D_ARRAY) {
+        // every touched page in one call
+        size_t page_bytes = (size_t)page_width(atlas) * page_height(atlas) * 4;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, first_page, page_width(atlas), page_height(atlas), end_page - first_page,
+            GL_RGBA, GL_UNSIGNED_BYTE, atlas->pixels + first_page * page_bytes); CHECK_GL();
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, page_width(atlas), page_height(atlas), GL_RGBA, GL_UNSIGNED_BYTE, atlas->pixels); CHECK_GL();
+    }
+    atlas->uploaded = atlas->count;
+    if (CHECK_GL_STAGE("pattern_atlas_upload")) return 1;
+    return 0;
+}
+
+void pattern_atlas_teardown(struct pattern_atlas *atlas) {
+    gl_state_delete_textures(1, &atlas->texture); CHECK_GL();
+    free(atlas->pixels);
+    atlas->pixels = 0;
+}
@@ -0,0 +1,44 @@
+//  MIT license
+#ifndef PATTERN_ATLAS_H
+#define PATTERN_ATLAS_H
+
+#include <stdint.h>
+#include "glad/glad.h"
+#include "gl_load.h"
+
+// Packs many small GL_SRGB8_ALPHA8 test patterns of the same size into
+// one texture instead of one texture object each. Patterns are tiled on
+// pages of PATTERN_ATLAS_PAGE_SIZE^2 texels, the pages are the layers of
+// a GL_TEXTURE_2D_ARRAY. Without texture arrays (GLES2, or too many
+// pages) everything goes on one (larger) GL_TEXTURE_2D page instead.
+// Patterns are staged on the CPU by pattern_atlas_add and sent with one
+// glTexSubImage3D (glTexSubImage2D) in pattern_atlas_upload.
+#define PATTERN_ATLAS_PAGE_SIZE 256
+
+struct pattern_atlas {
+    GLuint texture;
+    GLenum target;
+    int pattern_width;
+    int pattern_height;
+    // patterns per page row/column, pages of the array (1 for 2D)
+    int columns;
+    int rows;
+    int pages;
+    int capacity;
+    int count;
+    // patterns before this one are on the GPU
+    int uploaded;
+    // pages, as laid out in the texture
+    uint8_t *pixels;
+};
+
+int pattern_atlas_setup(struct pattern_atlas *atlas, enum gl_api api, int pattern_width, int pattern_height, int capacity);
+// stages an RGBA8 (sRGB encoded) pattern, returns its layer or -1 if full
+int pattern_atlas_add(struct pattern_atlas *atlas, const uint8_t *pixels);
+// as create_srgb8_a8_texture_grey_pma
+int pattern_atlas_add_grey_pma(struct pattern_atlas *atlas, uint8_t grey, uint8_t alpha);
+// sends the patterns added since the last upload
+int pattern_atlas_upload(struct pattern_atlas *atlas);
+void pattern_atlas_teardown(struct pattern_atlas *atlas);
+
+#endif
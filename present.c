@@ -0,0 +1,120 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "present.h"
+#include "gl_error.h"
+#include "gl_state.h"
+
+static const char *const names[PRESENT_STRATEGY_COUNT] = {"quad", "copy", "blit"};
+
+const char *present_strategy_name(enum present_strategy strategy) {
+    return strategy < PRESENT_STRATEGY_COUNT ? names[strategy] : "unknown";
+}
+
+int present_strategy_by_name(const char *name) {
+    for (int i = 0; i < PRESENT_STRATEGY_COUNT; ++i) {
+        if (!strcmp(names[i], name)) return i;
+    }
+    return -1;
+}
+
+// the lower-left width x height
+static void blit(GLuint read_framebuffer, GLuint draw_framebuffer, int width, int height) {
+    gl_state_bind_framebuffers(read_framebuffer, draw_framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST); CHECK_GL();
+}
+
+static void quad(struct present *present, struct fborender *target) {
+    GLfloat offset[] = {0, 0};
+    GLfloat scale[] = {1, 1};
+    GLfloat uv_scale[2];
+    fborender_uv_scale(target, uv_scale);
+    // the post-process blends (GL_ONE, GL_ONE), start from black
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    quadtest_render(present->quad, target->texture, present->ramp, offset, scale, uv_scale);
+}
+
+// one row of every sRGB value through each strategy into the default
+// framebuffer, exact if it reads back unchanged
+static void check(struct present *present, struct rt_pool *pool) {
+    struct fborender *src = rt_pool_acquire(pool, GL_SRGB8_ALPHA8, 256, 1, 0);
+    if (!src) {
+        present->supported[PRESENT_COPY] = present->supported[PRESENT_BLIT] = 0;
+        return;
+    }
+    uint8_t values[256 * 4], out[256 * 4];
+    for (int i = 0; i < 256; ++i) {
+        values[i * 4 + 0] = values[i * 4 + 1] = values[i * 4 + 2] = i;
+        // the targets are cleared opaque and blended additively
+        values[i * 4 + 3] = 255;
+    }
+    gl_state_bind_texture(0, GL_TEXTURE_2D, src->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, GL_RGBA, GL_UNSIGNED_BYTE, values); CHECK_GL();
+    glViewport(0, 0, 256, 1);
+    for (int strategy = 0; strategy < PRESENT_STRATEGY_COUNT; ++strategy) {
+        present->exact[strategy] = 0;
+        if (!present->supported[strategy]) continue;
+        if (present_render(present, strategy, src, 0)) {
+            present->supported[strategy] = 0;
+            continue;
+        }
+        glReadPixels(0, 0, 256, 1, GL_RGBA, GL_UNSIGNED_BYTE, out);
+        if (CHECK_GL()) continue;
+        int off = 0, max_diff = 0;
+        for (int i = 0; i < 256 * 4; ++i) {
+            int diff = abs(out[i] - values[i]);
+            if (diff) ++off;
+            if (diff > max_diff) max_diff = diff;
+        }
+        present->exact[strategy] = !off;
+        if (off) fprintf(stderr, "present: %s is off for %d of 256 sRGB values, by up to %d\n", names[strategy], off / 3, max_diff);
+    }
+    rt_pool_release(pool, src);
+}
+
+void present_setup(struct present *present, enum gl_api api, struct rt_pool *pool, struct quadtest *quad, GLuint ramp) {
+    present->quad = quad;
+    present->ramp = ramp;
+    // framebuffer blits: GL 3.0, GL ES 3.0
+    int has_blit = GLVersion.major >= 3 && glBlitFramebuffer;
+    present->supported[PRESENT_QUAD] = 1;
+    present->supported[PRESENT_COPY] = has_blit && fborender_has_texture_view(api);
+    present->supported[PRESENT_BLIT] = has_blit;
+    check(present, pool);
+    present->strategy = PRESENT_QUAD;
+    for (int strategy = PRESENT_STRATEGY_COUNT - 1; strategy > PRESENT_QUAD; --strategy) {
+        if (!present->exact[strategy]) continue;
+        present->strategy = strategy;
+        break;
+    }
+    for (int strategy = 0; strategy < PRESENT_STRATEGY_COUNT; ++strategy) {
+        fprintf(stderr, "present: %s %s\n", names[strategy], !present->supported[strategy] ? "not supported" :
+            present->exact[strategy] ? "exact" : "not exact");
+    }
+    fprintf(stderr, "present: using %s\n", names[present->strategy]);
+}
+
+int present_render(struct present *present, enum present_strategy strategy, struct fborender *target, int invalidate) {
+    if (strategy >= PRESENT_STRATEGY_COUNT || !present->supported[strategy]) return 1;
+    GLuint read_framebuffer = target->fbo;
+    if (strategy == PRESENT_COPY) {
+        if (target->format != GL_SRGB8_ALPHA8) return 1;
+        read_framebuffer = fborender_view_framebuffer(target, GL_RGBA8);
+        if (!read_framebuffer) return 1;
+    }
+    // blits cover the whole default framebuffer, the quad clears it
+    if (invalidate) {
+        fborender_invalidate_color(0);
+    } else {
+        gl_state_bind_framebuffer(0);
+    }
+    if (strategy == PRESENT_QUAD) {
+        quad(present, target);
+    } else {
+        blit(read_framebuffer, 0, target->width, target->height);
+        gl_state_bind_framebuffer(0);
+    }
+    return 0;
+}
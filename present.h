@@ -0,0 +1,49 @@
+//  MIT license
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+#include "fborender.h"
+#include "rt_pool.h"
+#include "quadtest.h"
+
+// How the fbo target gets to the default framebuffer:
+// quad: the ramp post-process, a fullscreen quad that encodes in its
+//   shader, for a default framebuffer that does not encode
+// copy: the same pixels without the pass, the encoded texels of an
+//   srgb8_a8 target blitted as they are through an rgba8 view of it
+// blit: glBlitFramebuffer of the target into a default framebuffer that
+//   encodes (GL_FRAMEBUFFER_SRGB), i.e. what rendering directly gives
+enum present_strategy {
+    PRESENT_QUAD,
+    PRESENT_COPY,
+    PRESENT_BLIT,
+    PRESENT_STRATEGY_COUNT
+};
+
+struct present {
+    struct quadtest *quad;
+    GLuint ramp;
+    // can run here, and gives every sRGB value back unchanged here
+    int supported[PRESENT_STRATEGY_COUNT];
+    int exact[PRESENT_STRATEGY_COUNT];
+    // picked by present_setup
+    enum present_strategy strategy;
+};
+
+const char *present_strategy_name(enum present_strategy strategy);
+// -1 if no such name
+int present_strategy_by_name(const char *name);
+// Finds out which strategies run here and which are exact, presenting a
+// row of every sRGB value with each, and picks the first exact one of
+// blit and copy, else quad (only one of blit and copy can be exact, as
+// the default framebuffer either encodes or not).
+// quad: the ramp post-process, ramp: its ramp.
+// Leaves the default framebuffer contents undefined.
+void present_setup(struct present *present, enum gl_api api, struct rt_pool *pool, struct quadtest *quad, GLuint ramp);
+// the rendered part of target (single sample) to the default framebuffer,
+// invalidate: let the driver drop what the default framebuffer held
+int present_render(struct present *present, enum present_strategy strategy, struct fborender *target, int invalidate);
+
+#endif
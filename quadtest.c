@@ -0,0 +1,402 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "quadtest.h"
+#include "gl_compile.h"
+#include "gl_error.h"
+#include "gl_ext.h"
+#include "srgb.h"
+
+GLuint create_a_texture(enum gl_api api, uint8_t *pixels, int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture); CHECK_GL();
+    gl_state_bind_texture(0, GL_TEXTURE_2D, texture); CHECK_GL();
+    if (api == GL_API_OPENGL) {
+        // GL_ALPHA is gone from the core profile: store red, sample it as
+        // (0, 0, 0, red) like an alpha texture
+        GLint swizzle[] = {GL_ZERO, GL_ZERO, GL_ZERO, GL_RED};
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle); CHECK_GL();
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    CHECK_GL_STAGE("create texture");
+    return texture;
+}
+
+GLuint create_srgb8_a8_texture(uint8_t *pixels, int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture); CHECK_GL();
+    gl_state_bind_texture(0, GL_TEXTURE_2D, texture); CHECK_GL();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels); CHECK_GL();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    CHECK_GL_STAGE("create texture");
+    return texture;
+}
+
+void fix_shader(char *dst, size_t dst_size, GLint major, char const *src) {
+    if (dst_size < strlen(src)+1) {
+        fprintf(stderr, "shader source buffer is too small, need at least: %ld\n", strlen(src)+1);
+        exit(1);
+    }
+    memcpy(dst, src, strlen(src)+1);
+    if (major == 2) return;
+    // already GLSL ES 3 (e.g. for texture arrays), nothing to convert
+    if (strstr(dst, "#version 300 es")) return;
+    char *v = strstr(dst, "#version 100");
+    if (!v) exit(1);
+    v[strlen("#version ")] = '3';
+    v[strlen("#version 300 ")] = 'e';
+    v[strlen("#version 300 e")] = 's';
+    while ((v = strstr(dst, "texture2D"))) {
+        memmove(v+2, v, strlen("texture"));
+        v[0] = ' ';
+        v[1] = ' ';
+    }
+    while ((v = strstr(dst, "varying"))) {
+        for (int i = 0; i < strlen("varying"); ++i) {
+            v[i] = ' ';
+        }
+    }
+    //fprintf(stderr, "pre: \n%s\n", src);
+    //fprintf(stderr, "post: \n%s\n", dst);
+}
+
+// the unit quad, into a new buffer, as attributes of the bound vertex array
+static void quad_vertices_setup(GLuint position_index, GLuint uv_index, GLuint *vertex_buffer, int *out_vertices_count) {
+    glGenBuffers(1, vertex_buffer); CHECK_GL();
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, *vertex_buffer); CHECK_GL();
+    size_t vertex_byte_count = 4 * sizeof (GLfloat);
+    size_t vertices_count = 6;
+    *out_vertices_count = vertices_count;
+    // ab
+    // cd
+    // (acb bcd)
+    GLfloat vertices_xy_uv[] = {
+         1.f, -1.f,     1.f, 1.f,   // a
+        -1.f, -1.f,     0.f, 1.f,   // c
+         1.f,  1.f,     1.f, 0.f,   // b
+         1.f,  1.f,     1.f, 0.f,   // b
+        -1.f, -1.f,     0.f, 1.f,   // c
+        -1.f,  1.f,     0.f, 0.f    // d
+    };
+    glBufferData(GL_ARRAY_BUFFER, vertices_count * vertex_byte_count, vertices_xy_uv, GL_STATIC_DRAW); CHECK_GL();
+    glEnableVertexAttribArray(position_index); CHECK_GL();
+    glVertexAttribPointer(position_index, 2, GL_FLOAT, GL_FALSE, vertex_byte_count, 0); CHECK_GL();
+    glEnableVertexAttribArray(uv_index); CHECK_GL();
+    glVertexAttribPointer(uv_index, 2, GL_FLOAT, GL_FALSE, vertex_byte_count, (void *)(2*sizeof (GL_FLOAT))); CHECK_GL();
+}
+
+// compiles and links, attribute i is bound to location i
+static GLuint quad_program(GLint major, char const *vsh_es2, char const *fsh_es2, char const *const attributes[], int attributes_count) {
+    char vsh[1000];
+    fix_shader(vsh, 1000, major, vsh_es2);
+    char fsh[1000];
+    fix_shader(fsh, 1000, major, fsh_es2);
+    GLuint program = 0;
+    GLuint vert_shader = 0;
+    GLuint frag_shader = 0;
+    if (gl_compile_program_start(vsh, fsh, &program, &vert_shader, &frag_shader)) {
+        exit(1);
+    }
+    for (int i = 0; i < attributes_count; ++i) {
+        glBindAttribLocation(program, i, attributes[i]); CHECK_GL();
+    }
+    if (gl_compile_program_finish(program, vert_shader, frag_shader)) {
+        exit(1);
+    }
+    CHECK_GL();
+    return program;
+}
+
+void quadtest_setup(GLint major, struct quadtest *test, char const *vsh_es2, char const *fsh_es2) {
+    char const *const attributes[] = {"position", "uv"};
+    test->position_index = 0;
+    test->uv_index = 1;
+    test->program = quad_program(major, vsh_es2, fsh_es2, attributes, 2);
+    test->texture_location = glGetUniformLocation(test->program, "tex"); CHECK_GL();
+    test->ramp_location = glGetUniformLocation(test->program, "ramp"); CHECK_GL();
+    test->offset_location = glGetUniformLocation(test->program, "offset"); CHECK_GL();
+    test->scale_location = glGetUniformLocation(test->program, "scale"); CHECK_GL();
+    test->uv_scale_location = glGetUniformLocation(test->program, "uv_scale"); CHECK_GL();
+    gl_uniform_cache_reset(&test->uniforms);
+    glGenVertexArrays(1, &test->vertex_array); CHECK_GL();
+    gl_state_bind_vertex_array(test->vertex_array); CHECK_GL();
+    quad_vertices_setup(test->position_index, test->uv_index, &test->vertex_buffer, &test->vertices_count);
+    CHECK_GL_STAGE("quadtest_setup");
+}
+
+GLuint create_a_texture_srgb_ramp(enum gl_api api) {
+    // 1/255 is smallest value in sRGB format
+    // in linear, that value is lmin=1/255/12.92
+    // lmin must map to nonzero when we lookup
+    // lmin in the srgb ramp
+    // so we need 1/lmin = 3066 at minimum.
+    // due to rounding/precision, 3277 is minimum
+    // make that 4096
+    int range = 4096;
+    int width = range;
+    int height = 1;
+    uint8_t pixels[width*height];
+    srgb_ramp(pixels, range);
+    return create_a_texture(api, pixels, width, height);
+}
+
+GLuint create_srgb8_a8_texture_grey_pma(int width, int height, uint8_t grey, uint8_t alpha) {
+    size_t rowbytes = width*4;
+    uint8_t pixels[rowbytes*height];
+    srgb_grey_pma_pixels(pixels, width, height, grey, alpha);
+    return create_srgb8_a8_texture(pixels, width, height);
+}
+
+void quadtest_render(struct quadtest *test, GLuint texture, GLuint ramp, GLfloat offset[2], GLfloat scale[2], GLfloat uv_scale[2]) {
+    // redundant state is filtered by gl_state, so only the first draw
+    // (or one after a change) reaches the driver with all of it
+    gl_state_enable(GL_CULL_FACE, 0);
+    gl_state_enable(GL_DEPTH_TEST, 0);
+    gl_state_enable(GL_BLEND, 1);
+    gl_state_use_program(test->program); CHECK_GL();
+    gl_state_bind_vertex_array(test->vertex_array); CHECK_GL();
+    gl_state_uniform2f(&test->uniforms, test->offset_location, offset[0], offset[1]); CHECK_GL();
+    gl_state_uniform2f(&test->uniforms, test->scale_location, scale[0], scale[1]); CHECK_GL();
+    if (test->uv_scale_location != -1) {
+        gl_state_uniform2f(&test->uniforms, test->uv_scale_location, uv_scale[0], uv_scale[1]); CHECK_GL();
+    }
+    gl_state_uniform1i(&test->uniforms, test->texture_location, 0); CHECK_GL();
+    gl_state_uniform1i(&test->uniforms, test->ramp_location, 1); CHECK_GL();
+    gl_state_bind_texture(0, GL_TEXTURE_2D, texture); CHECK_GL();
+    gl_state_bind_texture(1, GL_TEXTURE_2D, ramp); CHECK_GL();
+    // NOTE: texture must have pre-multiplied alpha
+    gl_state_blend_func(GL_ONE,       GL_ONE); CHECK_GL();
+    // (no GL_ARRAY_BUFFER bind needed, the attributes are vertex array state)
+    glDrawArrays(GL_TRIANGLES, 0, test->vertices_count); CHECK_GL();
+}
+
+void quadtest_teardown(struct quadtest *test) {
+    gl_state_delete_vertex_arrays(1, &test->vertex_array);
+    gl_state_delete_buffers(1, &test->vertex_buffer);
+    gl_state_delete_program(test->program);
+    gl_state_bind_vertex_array(0); CHECK_GL();
+}
+
+enum {
+    GRID_POSITION,
+    GRID_UV,
+    GRID_OFFSET,
+    GRID_SCALE,
+    GRID_LAYER,
+    GRID_ATTRIBUTES_COUNT
+};
+
+static char const *const grid_attributes[GRID_ATTRIBUTES_COUNT] = {"position", "uv", "offset", "scale", "layer"};
+
+// the layer is a pattern of a pattern_atlas, on page floor(layer /
+// tiles.y) at tile (column, row) of that page, tiles.x columns per page.
+// The fragment shader clamps the uv to the tile's outer texel centers, as
+// clamp to edge would for a texture of its own: at the very edge of the
+// tile nearest sampling would otherwise pick the neighbour's texel.
+#define GRID_VSH_MAIN \
+    " void main() {" \
+    "     vec4 pos;" \
+    "     pos.xy = position * scale + offset;" \
+    "     pos.z = 0.0;" \
+    "     pos.w = 1.0;" \
+    "     gl_Position = pos;" \
+    "     float page = floor((layer + 0.5) / tiles.y);" \
+    "     float tile = layer - page * tiles.y;" \
+    "     float row = floor((tile + 0.5) / tiles.x);" \
+    "     float column = tile - row * tiles.x;" \
+    "     f_tile = vec2(column, row);" \
+    "     f_uv.xy = uv;" \
+    "     f_uv.z = page;" \
+    " }"
+
+static char const *const grid_vsh =
+    " #version 100 //\n"
+    " varying in vec2 position;"
+    " in vec2 uv;"
+    " varying in vec2 offset;"
+    " varying in vec2 scale;"
+    " varying in float layer;"
+    " uniform vec2 tiles;"
+    " varying out highp vec3 f_uv;"
+    " varying out highp vec2 f_tile;"
+    GRID_VSH_MAIN;
+
+static char const *const grid_fsh =
+    " #version 100 //\n"
+    " uniform lowp sampler2D tex;"
+    " uniform highp vec2 tile_scale;"
+    " uniform highp vec2 half_texel;"
+    " in highp vec3 f_uv;"
+    " in highp vec2 f_tile;"
+    " varying out lowp vec4 fragmentColor;"
+    " precision mediump float;"
+    " void main() {"
+    "     highp vec2 uv = (f_tile + clamp(f_uv.xy, half_texel, 1.0 - half_texel)) * tile_scale;"
+    "     vec4 tx = texture2D(tex, uv);" // GLES3: texture
+    // NOTE: texture is assumed to be premultiplied alpha
+    "     fragmentColor = tx;"
+    " }";
+
+// texture arrays need GLSL ES 3.00, no conversion from 100 here
+static char const *const grid_array_vsh =
+    "#version 300 es\n"
+    " in vec2 position;"
+    " in vec2 uv;"
+    " in vec2 offset;"
+    " in vec2 scale;"
+    " in float layer;"
+    " uniform vec2 tiles;"
+    " out highp vec3 f_uv;"
+    " out highp vec2 f_tile;"
+    GRID_VSH_MAIN;
+
+static char const *const grid_array_fsh =
+    "#version 300 es\n"
+    " uniform lowp sampler2DArray tex;"
+    " uniform highp vec2 tile_scale;"
+    " uniform highp vec2 half_texel;"
+    " in highp vec3 f_uv;"
+    " in highp vec2 f_tile;"
+    " out lowp vec4 fragmentColor;"
+    " precision mediump float;"
+    " void main() {"
+    "     highp vec2 uv = (f_tile + clamp(f_uv.xy, half_texel, 1.0 - half_texel)) * tile_scale;"
+    "     vec4 tx = texture(tex, vec3(uv, f_uv.z));"
+    // NOTE: texture is assumed to be premultiplied alpha
+    "     fragmentColor = tx;"
+    " }";
+
+static int has_instancing(enum gl_api api, GLint major) {
+    // core since GL 3.3 and GL ES 3.0, GLES2 needs an extension
+    // (gl_load resolves the core names to the extension ones)
+    if (api == GL_API_OPENGL) return GLVersion.major > 3 || (GLVersion.major == 3 && GLVersion.minor >= 3);
+    if (major >= 3) return 1;
+    return glsrgb_has_extension("GL_EXT_instanced_arrays") || glsrgb_has_extension("GL_ANGLE_instanced_arrays");
+}
+
+int quadgrid_setup(enum gl_api api, GLint major, GLenum target, struct quadgrid *grid) {
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        grid->program = quad_program(major, grid_array_vsh, grid_array_fsh, grid_attributes, GRID_ATTRIBUTES_COUNT);
+    } else {
+        grid->program = quad_program(major, grid_vsh, grid_fsh, grid_attributes, GRID_ATTRIBUTES_COUNT);
+    }
+    grid->target = target;
+    grid->texture_location = glGetUniformLocation(grid->program, "tex"); CHECK_GL();
+    grid->tiles_location = glGetUniformLocation(grid->program, "tiles"); CHECK_GL();
+    grid->tile_scale_location = glGetUniformLocation(grid->program, "tile_scale"); CHECK_GL();
+    grid->half_texel_location = glGetUniformLocation(grid->program, "half_texel"); CHECK_GL();
+    gl_uniform_cache_reset(&grid->uniforms);
+    grid->instanced = has_instancing(api, major) && glDrawArraysInstanced && glVertexAttribDivisor;
+    grid->instances = 0;
+    grid->instances_count = 0;
+    glGenVertexArrays(1, &grid->vertex_array); CHECK_GL();
+    gl_state_bind_vertex_array(grid->vertex_array); CHECK_GL();
+    quad_vertices_setup(GRID_POSITION, GRID_UV, &grid->vertex_buffer, &grid->vertices_count);
+    glGenBuffers(1, &grid->instance_buffer); CHECK_GL();
+    if (grid->instanced) {
+        // per instance attributes, advance once per quad
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, grid->instance_buffer); CHECK_GL();
+        GLsizei stride = sizeof (struct quadgrid_instance);
+        glVertexAttribPointer(GRID_OFFSET, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(struct quadgrid_instance, offset)); CHECK_GL();
+        glVertexAttribPointer(GRID_SCALE, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(struct quadgrid_instance, scale)); CHECK_GL();
+        glVertexAttribPointer(GRID_LAYER, 1, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void *)offsetof(struct quadgrid_instance, layer)); CHECK_GL();
+        for (int i = GRID_OFFSET; i < GRID_ATTRIBUTES_COUNT; ++i) {
+            glEnableVertexAttribArray(i); CHECK_GL();
+            glVertexAttribDivisor(i, 1); CHECK_GL();
+        }
+    }
+    fprintf(stderr, "quadgrid: %s\n", grid->instanced ? "instanced, one draw per grid" : "no instancing, one draw per quad");
+    if (CHECK_GL_STAGE("quadgrid_setup")) return 1;
+    return 0;
+}
+
+int quadgrid_set_instances(struct quadgrid *grid, const struct quadgrid_instance *instances, int count) {
+    size_t size = count * sizeof (struct quadgrid_instance);
+    if (grid->instanced) {
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, grid->instance_buffer); CHECK_GL();
+        glBufferData(GL_ARRAY_BUFFER, size, instances, GL_STATIC_DRAW); CHECK_GL();
+    } else {
+        struct quadgrid_instance *copy = realloc(grid->instances, size);
+        if (!copy && size) {
+            fprintf(stderr, "out of mem\n");
+            return 1;
+        }
+        memcpy(copy, instances, size);
+        grid->instances = copy;
+    }
+    grid->instances_count = count;
+    if (CHECK_GL_STAGE("quadgrid_set_instances")) return 1;
+    return 0;
+}
+
+int quadgrid_grey_alpha_instances(struct quadgrid_instance *out, struct pattern_atlas *atlas) {
+    int size = 256;
+    for (int alpha = 0; alpha < size; ++alpha) {
+        for (int grey = 0; grey < size; ++grey) {
+            int layer = pattern_atlas_add_grey_pma(atlas, grey, alpha);
+            if (layer < 0) {
+                fprintf(stderr, "pattern_atlas full\n");
+                return 1;
+            }
+            struct quadgrid_instance *instance = out + alpha * size + grey;
+            instance->offset[0] = -1.f + (2 * grey + 1) / (float)size;
+            instance->offset[1] = -1.f + (2 * alpha + 1) / (float)size;
+            instance->scale[0] = 1.f / size;
+            instance->scale[1] = 1.f / size;
+            instance->grey = grey;
+            instance->alpha = alpha;
+            instance->layer = layer;
+        }
+    }
+    return 0;
+}
+
+void quadgrid_render(struct quadgrid *grid, struct pattern_atlas *atlas) {
+    gl_state_enable(GL_CULL_FACE, 0);
+    gl_state_enable(GL_DEPTH_TEST, 0);
+    gl_state_enable(GL_BLEND, 1);
+    gl_state_use_program(grid->program); CHECK_GL();
+    gl_state_bind_vertex_array(grid->vertex_array); CHECK_GL();
+    gl_state_uniform1i(&grid->uniforms, grid->texture_location, 0); CHECK_GL();
+    gl_state_uniform2f(&grid->uniforms, grid->tiles_location, atlas->columns, atlas->columns * atlas->rows); CHECK_GL();
+    gl_state_uniform2f(&grid->uniforms, grid->tile_scale_location, 1.f / atlas->columns, 1.f / atlas->rows); CHECK_GL();
+    gl_state_uniform2f(&grid->uniforms, grid->half_texel_location, .5f / atlas->pattern_width, .5f / atlas->pattern_height); CHECK_GL();
+    gl_state_bind_texture(0, atlas->target, atlas->texture); CHECK_GL();
+    // NOTE: texture must have pre-multiplied alpha
+    gl_state_blend_func(GL_ONE,       GL_ONE); CHECK_GL();
+    if (grid->instanced) {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, grid->vertices_count, grid->instances_count); CHECK_GL();
+        return;
+    }
+    // the instance attributes are not arrays here, so they read the
+    // current (constant) attribute values
+    for (int i = 0; i < grid->instances_count; ++i) {
+        struct quadgrid_instance *instance = grid->instances + i;
+        glVertexAttrib2f(GRID_OFFSET, instance->offset[0], instance->offset[1]);
+        glVertexAttrib2f(GRID_SCALE, instance->scale[0], instance->scale[1]);
+        glVertexAttrib1f(GRID_LAYER, instance->layer);
+        glDrawArrays(GL_TRIANGLES, 0, grid->vertices_count);
+    }
+    CHECK_GL();
+}
+
+void quadgrid_teardown(struct quadgrid *grid) {
+    gl_state_delete_vertex_arrays(1, &grid->vertex_array);
+    GLuint buffers[] = {grid->vertex_buffer, grid->instance_buffer};
+    gl_state_delete_buffers(2, buffers);
+    gl_state_delete_program(grid->program);
+    gl_state_bind_vertex_array(0); CHECK_GL();
+    free(grid->instances);
+    grid->instances = 0;
+}
@@ -0,0 +1,82 @@
+//  MIT license
+#ifndef QUADTEST_H
+#define QUADTEST_H
+
+#include <stdint.h>
+#include "glad/glad.h"
+#include "gl_load.h"
+#include "gl_state.h"
+#include "pattern_atlas.h"
+
+struct quadtest {
+    GLuint program;
+    GLuint position_index;
+    GLuint uv_index;
+    GLint texture_location;
+    GLint ramp_location;
+    GLint offset_location;
+    GLint scale_location;
+    GLint uv_scale_location;
+    GLuint vertex_array;
+    GLuint vertex_buffer;
+    int vertices_count;
+    struct gl_uniform_cache uniforms;
+};
+
+GLuint create_a_texture(enum gl_api api, uint8_t *pixels, int width, int height);
+GLuint create_srgb8_a8_texture(uint8_t *pixels, int width, int height);
+GLuint create_a_texture_srgb_ramp(enum gl_api api);
+GLuint create_srgb8_a8_texture_grey_pma(int width, int height, uint8_t grey, uint8_t alpha);
+
+// assume gl es 2 (version 100) shader, and convert to gl es 3
+void fix_shader(char *dst, size_t dst_size, GLint major, char const *src);
+
+void quadtest_setup(GLint major, struct quadtest *test, char const *vsh_es2, char const *fsh_es2);
+// uv_scale: for shaders with a uv_scale uniform, ignored otherwise
+void quadtest_render(struct quadtest *test, GLuint texture, GLuint ramp, GLfloat offset[2], GLfloat scale[2], GLfloat uv_scale[2]);
+void quadtest_teardown(struct quadtest *test);
+
+// One quad per instance, the per-quad values of quadtest_render (offset,
+// scale) plus which pattern_atlas layer to show come from an instance
+// buffer, so a whole grid of patches is a single draw.
+// Without instancing (GLES2 lacking GL_EXT/ANGLE_instanced_arrays) the
+// same shader is fed one quad per draw through constant attributes.
+struct quadgrid_instance {
+    GLfloat offset[2];
+    GLfloat scale[2];
+    // what the layer holds, not read by the shader
+    GLubyte grey;
+    GLubyte alpha;
+    GLushort layer;
+};
+
+struct quadgrid {
+    GLuint program;
+    // of the pattern_atlas the program samples
+    GLenum target;
+    GLint texture_location;
+    GLint tiles_location;
+    GLint tile_scale_location;
+    GLint half_texel_location;
+    GLuint vertex_array;
+    GLuint vertex_buffer;
+    GLuint instance_buffer;
+    int vertices_count;
+    int instances_count;
+    int instanced;
+    // only kept for the one draw per quad fallback
+    struct quadgrid_instance *instances;
+    struct gl_uniform_cache uniforms;
+};
+
+// target: of the pattern_atlas to draw from
+int quadgrid_setup(enum gl_api api, GLint major, GLenum target, struct quadgrid *grid);
+// copies count instances, replacing the previous ones
+int quadgrid_set_instances(struct quadgrid *grid, const struct quadgrid_instance *instances, int count);
+// 256x256 patches covering clip space, column = grey, row = alpha,
+// adds the grey_pma pattern of each pair to atlas
+int quadgrid_grey_alpha_instances(struct quadgrid_instance *out, struct pattern_atlas *atlas);
+void quadgrid_render(struct quadgrid *grid, struct pattern_atlas *atlas);
+void quadgrid_teardown(struct quadgrid *grid);
+
+#endif
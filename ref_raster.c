@@ -0,0 +1,188 @@
+//  MIT license
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ref_raster.h"
+#include "srgb.h"
+#include "tile_pool.h"
+
+// a recorded quad in window space
+struct prepared_quad {
+    const struct ref_raster_texture *texture;
+    // covered pixels, [x0, x1) x [y0, y1)
+    int x0, x1, y0, y1;
+    // window position of the quad's uv (0, 1) corner and its extent,
+    // negative for a mirrored quad
+    float left, bottom, width, height;
+    float uv_scale[2];
+};
+
+struct job {
+    struct ref_raster *raster;
+    struct prepared_quad *quads;
+    float decode[256];
+    uint8_t clear[4];
+    uint8_t *out;
+};
+
+static uint8_t encode(float linear) {
+    return linear_to_srgb(linear) * 255.0f + 0.5f;
+}
+
+static uint8_t unorm8(float value) {
+    if (!(value > 0.0f)) return 0;
+    if (value > 1.0f) return 255;
+    return value * 255.0f + 0.5f;
+}
+
+int ref_raster_setup(struct ref_raster *raster, int width, int height, int threads) {
+    raster->width = width;
+    raster->height = height;
+    raster->threads = tile_pool_threads(threads);
+    for (int i = 0; i < 4; ++i) {
+        raster->clear[i] = 0;
+    }
+    raster->quads = 0;
+    raster->quads_count = 0;
+    raster->quads_capacity = 0;
+    return 0;
+}
+
+void ref_raster_clear(struct ref_raster *raster, const float color[4]) {
+    for (int i = 0; i < 4; ++i) {
+        raster->clear[i] = color[i];
+    }
+    raster->quads_count = 0;
+}
+
+int ref_raster_quad(struct ref_raster *raster, const struct ref_raster_texture *texture,
+        const float offset[2], const float scale[2], const float uv_scale[2]) {
+    if (raster->quads_count == raster->quads_capacity) {
+        int capacity = raster->quads_capacity ? raster->quads_capacity * 2 : 64;
+        struct ref_raster_quad *quads = realloc(raster->quads, capacity * sizeof (struct ref_raster_quad));
+        if (!quads) {
+            fprintf(stderr, "out of mem\n");
+            return 1;
+        }
+        raster->quads = quads;
+        raster->quads_capacity = capacity;
+    }
+    struct ref_raster_quad *quad = raster->quads + raster->quads_count++;
+    quad->texture = texture;
+    for (int i = 0; i < 2; ++i) {
+        quad->offset[i] = offset[i];
+        quad->scale[i] = scale[i];
+        quad->uv_scale[i] = uv_scale[i];
+    }
+    return 0;
+}
+
+// first pixel whose center is at or after edge, clamped to [0, size]
+static int first_pixel(float edge, int size) {
+    float first = ceilf(edge - 0.5f);
+    if (first < 0) return 0;
+    if (first > size) return size;
+    return first;
+}
+
+static void prepare(struct ref_raster *raster, const struct ref_raster_quad *quad, struct prepared_quad *out) {
+    // as the vertex shader and viewport transform compute it, in float:
+    // position -1 has uv 0 in x and uv 1 in y
+    float left = (-quad->scale[0] + quad->offset[0] + 1.0f) * 0.5f * raster->width;
+    float right = (quad->scale[0] + quad->offset[0] + 1.0f) * 0.5f * raster->width;
+    float bottom = (-quad->scale[1] + quad->offset[1] + 1.0f) * 0.5f * raster->height;
+    float top = (quad->scale[1] + quad->offset[1] + 1.0f) * 0.5f * raster->height;
+    out->texture = quad->texture;
+    out->x0 = first_pixel(fminf(left, right), raster->width);
+    out->x1 = first_pixel(fmaxf(left, right), raster->width);
+    out->y0 = first_pixel(fminf(bottom, top), raster->height);
+    out->y1 = first_pixel(fmaxf(bottom, top), raster->height);
+    out->left = left;
+    out->bottom = bottom;
+    out->width = right - left;
+    out->height = top - bottom;
+    out->uv_scale[0] = quad->uv_scale[0];
+    out->uv_scale[1] = quad->uv_scale[1];
+}
+
+// nearest texel index of coordinate, clamp to edge
+static int texel(float coordinate, int size) {
+    float i = floorf(coordinate * size);
+    if (!(i > 0)) return 0;
+    if (i >= size) return size - 1;
+    return i;
+}
+
+static void draw_rows(struct job *job, const struct prepared_quad *quad, int row0, int row1) {
+    int width = job->raster->width;
+    const struct ref_raster_texture *texture = quad->texture;
+    if (row0 < quad->y0) row0 = quad->y0;
+    if (row1 > quad->y1) row1 = quad->y1;
+    for (int py = row0; py < row1; ++py) {
+        float v = 1.0f - (py + 0.5f - quad->bottom) / quad->height;
+        const uint8_t *texels = texture->pixels + (size_t)texel(v * quad->uv_scale[1], texture->height) * texture->width * 4;
+        uint8_t *pixel = job->out + ((size_t)py * width + quad->x0) * 4;
+        for (int px = quad->x0; px < quad->x1; ++px, pixel += 4) {
+            float u = (px + 0.5f - quad->left) / quad->width;
+            const uint8_t *src = texels + texel(u * quad->uv_scale[0], texture->width) * 4;
+            // GL_ONE, GL_ONE: dst decoded, added to the (pre-multiplied)
+            // source in linear, clamped and encoded again
+            for (int c = 0; c < 3; ++c) {
+                float sum = job->decode[src[c]] + job->decode[pixel[c]];
+                pixel[c] = encode(sum > 1.0f ? 1.0f : sum);
+            }
+            pixel[3] = unorm8((src[3] + pixel[3]) / 255.0f);
+        }
+    }
+}
+
+static void draw_tile(void *arg, int worker, int tile) {
+    (void)worker;
+    struct job *job = arg;
+    struct ref_raster *raster = job->raster;
+    int row0 = tile * TILE_POOL_ROWS;
+    int row1 = row0 + TILE_POOL_ROWS < raster->height ? row0 + TILE_POOL_ROWS : raster->height;
+    uint8_t *row = job->out + (size_t)row0 * raster->width * 4;
+    for (size_t i = 0; i < (size_t)(row1 - row0) * raster->width; ++i, row += 4) {
+        for (int c = 0; c < 4; ++c) {
+            row[c] = job->clear[c];
+        }
+    }
+    // in draw order, each pixel belongs to this tile only
+    for (int i = 0; i < raster->quads_count; ++i) {
+        const struct prepared_quad *quad = job->quads + i;
+        if (quad->y1 <= row0 || quad->y0 >= row1 || quad->x0 == quad->x1) continue;
+        draw_rows(job, quad, row0, row1);
+    }
+}
+
+int ref_raster_finish(struct ref_raster *raster, uint8_t *out) {
+    struct job job;
+    job.raster = raster;
+    job.out = out;
+    for (int i = 0; i < 256; ++i) {
+        job.decode[i] = srgb_to_linear(i / 255.0f);
+    }
+    for (int c = 0; c < 3; ++c) {
+        job.clear[c] = encode(raster->clear[c] > 1.0f ? 1.0f : raster->clear[c]);
+    }
+    job.clear[3] = unorm8(raster->clear[3]);
+    job.quads = malloc((raster->quads_count ? raster->quads_count : 1) * sizeof (struct prepared_quad));
+    if (!job.quads) {
+        fprintf(stderr, "out of mem\n");
+        return 1;
+    }
+    for (int i = 0; i < raster->quads_count; ++i) {
+        prepare(raster, raster->quads + i, job.quads + i);
+    }
+    tile_pool_run(tile_pool_tiles(raster->height), raster->threads, draw_tile, &job);
+    free(job.quads);
+    return 0;
+}
+
+void ref_raster_teardown(struct ref_raster *raster) {
+    free(raster->quads);
+    raster->quads = 0;
+    raster->quads_count = 0;
+    raster->quads_capacity = 0;
+}
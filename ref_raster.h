@@ -0,0 +1,52 @@
+//  MIT license
+#ifndef REF_RASTER_H
+#define REF_RASTER_H
+
+#include <stdint.h>
+
+// CPU reference of what quadtest_render (and quadgrid_render) draw into
+// an sRGB framebuffer, to check a driver without trusting it: the unit
+// quad at position * scale + offset, uv * uv_scale sampled nearest with
+// clamp to edge from an sRGB8_ALPHA8 texture, blended GL_ONE, GL_ONE in
+// linear float and encoded to sRGB on store (as GL_FRAMEBUFFER_SRGB).
+// Draws are recorded, then ref_raster_finish runs them in order over
+// tiles of scanlines, spread across threads.
+// A pixel is covered when its center is in [x0, x1) x [y0, y1) of the
+// quad in window space (GL leaves exact ties to the implementation, this
+// is what Mesa llvmpipe does).
+struct ref_raster_texture {
+    // rgba8 sRGB texels, rows in upload order (first row is v = 0)
+    const uint8_t *pixels;
+    int width, height;
+};
+
+struct ref_raster_quad {
+    const struct ref_raster_texture *texture;
+    float offset[2];
+    float scale[2];
+    float uv_scale[2];
+};
+
+struct ref_raster {
+    int width, height;
+    int threads;
+    // linear, as glClearColor with GL_FRAMEBUFFER_SRGB
+    float clear[4];
+    struct ref_raster_quad *quads;
+    int quads_count;
+    int quads_capacity;
+};
+
+// threads: 0 for one per online cpu
+int ref_raster_setup(struct ref_raster *raster, int width, int height, int threads);
+// starts a frame: drops the recorded draws
+void ref_raster_clear(struct ref_raster *raster, const float color[4]);
+// the texture must live until ref_raster_finish
+int ref_raster_quad(struct ref_raster *raster, const struct ref_raster_texture *texture,
+    const float offset[2], const float scale[2], const float uv_scale[2]);
+// the frame as glReadPixels GL_RGBA/GL_UNSIGNED_BYTE gives it (first row
+// at the bottom), width * height * 4 bytes
+int ref_raster_finish(struct ref_raster *raster, uint8_t *out);
+void ref_raster_teardown(struct ref_raster *raster);
+
+#endif
@@ -0,0 +1,89 @@
+//  MIT license
+#include <stdio.h>
+#include <stddef.h>
+#include <time.h>
+#include "rt_pool.h"
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+void rt_pool_setup(struct rt_pool *pool, enum gl_api api, double ttl) {
+    pool->api = api;
+    pool->ttl = ttl;
+    for (int i = 0; i < RT_POOL_SIZE; ++i) {
+        pool->entries[i].used = 0;
+        pool->entries[i].acquired = 0;
+    }
+    pool->created = 0;
+    pool->reused = 0;
+    pool->evicted = 0;
+}
+
+static void evict(struct rt_pool *pool, struct rt_pool_entry *entry) {
+    fborender_teardown(&entry->target);
+    entry->used = 0;
+    ++pool->evicted;
+}
+
+struct fborender *rt_pool_acquire(struct rt_pool *pool, GLenum format, int width, int height, int samples) {
+    struct rt_pool_entry *best = 0;
+    struct rt_pool_entry *free_entry = 0;
+    struct rt_pool_entry *oldest = 0;
+    for (int i = 0; i < RT_POOL_SIZE; ++i) {
+        struct rt_pool_entry *entry = pool->entries + i;
+        if (!entry->used) {
+            if (!free_entry) free_entry = entry;
+            continue;
+        }
+        if (entry->acquired) continue;
+        if (!oldest || entry->released_at < oldest->released_at) oldest = entry;
+        struct fborender *target = &entry->target;
+        if (target->format != format || target->samples != samples) continue;
+        if (!fborender_fits(target, width, height)) continue;
+        // the smallest allocation that fits
+        if (!best || target->storage_width * target->storage_height < best->target.storage_width * best->target.storage_height) best = entry;
+    }
+    if (best) {
+        fborender_resize(&best->target, width, height);
+        best->acquired = 1;
+        ++pool->reused;
+        return &best->target;
+    }
+    if (!free_entry && oldest) {
+        // full, make room with the least recently released target
+        evict(pool, oldest);
+        free_entry = oldest;
+    }
+    if (!free_entry) {
+        fprintf(stderr, "rt_pool: all %d targets acquired\n", RT_POOL_SIZE);
+        return 0;
+    }
+    if (fborender_setup(&free_entry->target, pool->api, format, samples, width, height)) return 0;
+    free_entry->used = 1;
+    free_entry->acquired = 1;
+    ++pool->created;
+    return &free_entry->target;
+}
+
+void rt_pool_release(struct rt_pool *pool, struct fborender *target) {
+    struct rt_pool_entry *entry = (struct rt_pool_entry *)((char *)target - offsetof(struct rt_pool_entry, target));
+    entry->acquired = 0;
+    entry->released_at = now();
+}
+
+void rt_pool_evict(struct rt_pool *pool) {
+    double t = now();
+    for (int i = 0; i < RT_POOL_SIZE; ++i) {
+        struct rt_pool_entry *entry = pool->entries + i;
+        if (entry->used && !entry->acquired && t - entry->released_at > pool->ttl) evict(pool, entry);
+    }
+}
+
+void rt_pool_teardown(struct rt_pool *pool) {
+    for (int i = 0; i < RT_POOL_SIZE; ++i) {
+        if (pool->entries[i].used) evict(pool, pool->entries + i);
+    }
+}
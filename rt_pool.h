@@ -0,0 +1,37 @@
+//  MIT license
+#ifndef RT_POOL_H
+#define RT_POOL_H
+
+#include "fborender.h"
+
+// Render targets (fborender) kept across frames, keyed by (format,
+// width, height, samples). Acquiring reuses a released target whose
+// allocation fits, so per frame acquire/release creates and deletes no
+// GL objects. Targets released for longer than ttl seconds are deleted
+// by rt_pool_evict (call once per frame).
+#define RT_POOL_SIZE 16
+
+struct rt_pool_entry {
+    struct fborender target;
+    int used;
+    int acquired;
+    double released_at;
+};
+
+struct rt_pool {
+    enum gl_api api;
+    double ttl;
+    struct rt_pool_entry entries[RT_POOL_SIZE];
+    unsigned long created;
+    unsigned long reused;
+    unsigned long evicted;
+};
+
+void rt_pool_setup(struct rt_pool *pool, enum gl_api api, double ttl);
+// 0 if the format is not renderable here, or every entry is acquired
+struct fborender *rt_pool_acquire(struct rt_pool *pool, GLenum format, int width, int height, int samples);
+void rt_pool_release(struct rt_pool *pool, struct fborender *target);
+void rt_pool_evict(struct rt_pool *pool);
+void rt_pool_teardown(struct rt_pool *pool);
+
+#endif
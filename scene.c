@@ -0,0 +1,247 @@
+//  MIT license
+#include <stdio.h>
+#include <stdlib.h>
+#include "scene.h"
+#include "gl_error.h"
+#include "gl_state.h"
+#include "fborender.h"
+#include "msaa.h"
+#include "srgb.h"
+
+int scene_setup(struct scene *scene, enum gl_api api, GLint gl_major, int width, int height, int grid) {
+    // load a texture in sRGB with the lowest value possible
+    // (i.e. = 1, which is 0 in linear)
+    scene->darkgrey_texture = create_srgb8_a8_texture_grey_pma(4, 4, 1, 255);
+    if (!scene->darkgrey_texture) {
+        return 1;
+    }
+    srgb_grey_pma_pixels(scene->darkgrey_pixels, 4, 4, 1, 255);
+    scene->grid_instances = 0;
+    // for fbo rendering when we don't have sRGB framebuffer, we
+    // take linear data to sRGB via a ramp_texture
+    scene->srgb_ramp = create_a_texture_srgb_ramp(api);
+    if (!scene->srgb_ramp) {
+        return 1;
+    }
+    // released targets are kept for reuse, deleted after 2s unused
+    rt_pool_setup(&scene->targets, api, 2.0);
+    scene->fbo_format = GL_SRGB8_ALPHA8;
+    scene->fbo_samples = 0;
+    scene->invalidate = fborender_has_invalidate(api);
+    scene->linear_window = 0;
+    scene->compute_tile = 0;
+    compute_post_setup(&scene->compute, api);
+    struct fborender *target = rt_pool_acquire(&scene->targets, scene->fbo_format, width, height, 0);
+    if (!target) {
+        return 1;
+    }
+    rt_pool_release(&scene->targets, target);
+    if (CHECK_GL()) return 1;
+    quadtest_setup(gl_major, &scene->quad_darkgrey,
+        " #version 100 //\n"
+        " varying in vec2 position;"
+        " uniform vec2 offset;"
+        " uniform vec2 scale;"
+        " in vec2 uv;"
+        " varying out lowp vec2 f_uv;"
+        " void main() {"
+        "     vec4 pos;"
+        "     pos.xy = position * scale + offset;"
+        "     pos.z = 0.0;"
+        "     pos.w = 1.0;"
+        "     gl_Position = pos;"
+        "     f_uv = uv;"
+        " }",
+        " #version 100 //\n"
+        " uniform lowp sampler2D tex;"
+        " in lowp vec2 f_uv;"
+        " varying out lowp vec4 fragmentColor;"
+        " precision mediump float;"
+        " void main() {"
+        "     vec4 tx = texture2D(tex, f_uv);" // GLES3: texture
+        // NOTE: texture is assumed to be premultiplied alpha
+        "     fragmentColor = tx;"
+        " }");
+    quadtest_setup(gl_major, &scene->quad_postprocess,
+        " #version 100 //\n"
+        " varying in vec2 position;"
+        " uniform vec2 offset;"
+        " uniform vec2 scale;"
+        " in vec2 uv;"
+        // the fbo texture can be larger than what was rendered to it
+        " uniform vec2 uv_scale;"
+        " varying out mediump vec2 f_uv;"
+        " void main() {"
+        "     vec4 pos;"
+        "     pos.xy = position * scale + offset;"
+        "     pos.z = 0.0;"
+        "     pos.w = 1.0;"
+        "     gl_Position = pos;"
+        // the fbo texture has its first row at the bottom
+        "     f_uv = vec2(uv.x, 1.0 - uv.y) * uv_scale;"
+        " }",
+        " #version 100 //\n"
+        " uniform highp sampler2D tex;"
+        " uniform lowp sampler2D ramp;"
+        " in mediump vec2 f_uv;"
+        " varying out lowp vec4 fragmentColor;"
+        " precision mediump float;"
+        " void main() {"
+        "     vec4 tx = texture2D(tex, f_uv);" // GLES3: texture
+        // NOTE: texture is assumed to be premultiplied alpha
+        "     vec4 srgb_a = vec4(texture2D(ramp, vec2(tx.r, 0.0)).a,"
+        "                        texture2D(ramp, vec2(tx.g, 0.0)).a,"
+        "                        texture2D(ramp, vec2(tx.b, 0.0)).a,"
+        "                        tx.a);"
+        // calculation instead of ramp
+        //"     float cs;"
+        //"     float cl = tx.r;"
+        //"     if (cl < 0.0031308) cs = 12.92 * cl;"
+        //"     else cs = 1.055 * pow(cl, 0.41666) - 0.055;"
+        //"     srgb_a.rgb = vec3(cs,cs,cs);"
+        "     fragmentColor = srgb_a;"
+        " }");
+    present_setup(&scene->present, api, &scene->targets, &scene->quad_postprocess, scene->srgb_ramp);
+    scene->present_strategy = scene->present.strategy;
+    scene->grid = grid;
+    if (grid) {
+        // the 4x4 grey_pma texture of each pair, all in one atlas
+        if (pattern_atlas_setup(&scene->patterns, api, 4, 4, 256 * 256)) {
+            return 1;
+        }
+        if (quadgrid_setup(api, gl_major, scene->patterns.target, &scene->quad_grid)) {
+            return 1;
+        }
+        struct quadgrid_instance *instances = malloc(256 * 256 * sizeof (struct quadgrid_instance));
+        if (!instances) {
+            fprintf(stderr, "out of mem\n");
+            return 1;
+        }
+        scene->grid_instances = instances;
+        if (quadgrid_grey_alpha_instances(instances, &scene->patterns) ||
+            pattern_atlas_upload(&scene->patterns) ||
+            quadgrid_set_instances(&scene->quad_grid, instances, 256 * 256)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void scene_draw(struct scene *scene) {
+    if (scene->grid) {
+        quadgrid_render(&scene->quad_grid, &scene->patterns);
+    } else {
+        GLfloat offset[] = {0, 0};
+        GLfloat scale[] = {0.5, 0.5};
+        GLfloat uv_scale[] = {1, 1};
+        quadtest_render(&scene->quad_darkgrey, scene->darkgrey_texture, 0, offset, scale, uv_scale);
+    }
+}
+
+// from the (single sample) fbo target to the default framebuffer
+static int scene_post_process(struct scene *scene, struct fborender *target, int width, int height) {
+    int failed = 0;
+    if (scene->linear_window) gl_state_enable(GL_FRAMEBUFFER_SRGB, 0);
+    if (scene->compute_tile) {
+        struct fborender *encoded = rt_pool_acquire(&scene->targets, GL_RGBA8, width, height, 0);
+        failed = !encoded || compute_post_render(&scene->compute, scene->compute_tile, target, scene->srgb_ramp, encoded);
+        if (encoded) {
+            // the blit covers the whole default framebuffer, no clear
+            if (scene->invalidate) fborender_invalidate_color(0);
+            if (!failed) compute_post_present(encoded);
+            if (scene->invalidate) fborender_invalidate_color(encoded->fbo);
+            rt_pool_release(&scene->targets, encoded);
+        }
+    } else {
+        failed = present_render(&scene->present, scene->present_strategy, target, scene->invalidate);
+    }
+    // only the default framebuffer is presented
+    if (scene->invalidate) fborender_invalidate_color(target->fbo);
+    gl_state_bind_framebuffer(0);
+    if (scene->linear_window) gl_state_enable(GL_FRAMEBUFFER_SRGB, 1);
+    return failed;
+}
+
+int scene_render(struct scene *scene, int use_fbo, int width, int height) {
+    struct fborender *target = 0;
+    struct fborender *ms_target = 0;
+    if (use_fbo) {
+        target = rt_pool_acquire(&scene->targets, scene->fbo_format, width, height, 0);
+        if (!target) return 1;
+        if (scene->fbo_samples > 1) {
+            ms_target = rt_pool_acquire(&scene->targets, scene->fbo_format, width, height, scene->fbo_samples);
+            if (!ms_target) {
+                rt_pool_release(&scene->targets, target);
+                return 1;
+            }
+        }
+    }
+    GLuint fbo = ms_target ? ms_target->fbo : target ? target->fbo : 0;
+    if (scene->invalidate) {
+        fborender_invalidate_color(fbo);
+    } else {
+        gl_state_bind_framebuffer(fbo);
+    }
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    scene_draw(scene);
+    if (use_fbo) {
+        if (ms_target) {
+            msaa_resolve(ms_target, target);
+            if (scene->invalidate) fborender_invalidate_color(ms_target->fbo);
+            rt_pool_release(&scene->targets, ms_target);
+        }
+        int failed = scene_post_process(scene, target, width, height);
+        rt_pool_release(&scene->targets, target);
+        if (failed) return 1;
+    }
+    rt_pool_evict(&scene->targets);
+    // in GL_CHECK_DEFERRED mode this is the only poll per frame
+    if (CHECK_GL_STAGE("frame")) return 1;
+    return 0;
+}
+
+int scene_reference(struct scene *scene, struct ref_raster *raster, uint8_t *out) {
+    float clear[] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float uv_scale[] = {1, 1};
+    ref_raster_clear(raster, clear);
+    if (!scene->grid) {
+        float offset[] = {0, 0};
+        float scale[] = {0.5, 0.5};
+        struct ref_raster_texture texture = {scene->darkgrey_pixels, 4, 4};
+        return ref_raster_quad(raster, &texture, offset, scale, uv_scale) || ref_raster_finish(raster, out);
+    }
+    // each grid pattern is one grey_pma texel repeated, 1x1 will do
+    int count = 256 * 256;
+    uint8_t *texels = malloc(count * 4);
+    struct ref_raster_texture *textures = malloc(count * sizeof (struct ref_raster_texture));
+    int failed = !texels || !textures;
+    for (int i = 0; i < count && !failed; ++i) {
+        struct quadgrid_instance *instance = scene->grid_instances + i;
+        srgb_grey_pma(instance->grey, instance->alpha, texels + i * 4);
+        textures[i].pixels = texels + i * 4;
+        textures[i].width = 1;
+        textures[i].height = 1;
+        failed = ref_raster_quad(raster, textures + i, instance->offset, instance->scale, uv_scale);
+    }
+    if (!failed) failed = ref_raster_finish(raster, out);
+    free(texels);
+    free(textures);
+    return failed;
+}
+
+void scene_teardown(struct scene *scene) {
+    rt_pool_teardown(&scene->targets);
+    quadtest_teardown(&scene->quad_darkgrey);
+    quadtest_teardown(&scene->quad_postprocess);
+    compute_post_teardown(&scene->compute);
+    gl_state_delete_textures(1, &scene->darkgrey_texture);
+    gl_state_delete_textures(1, &scene->srgb_ramp); CHECK_GL();
+    if (scene->grid) {
+        quadgrid_teardown(&scene->quad_grid);
+        pattern_atlas_teardown(&scene->patterns);
+    }
+    free(scene->grid_instances);
+    scene->grid_instances = 0;
+}
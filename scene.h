@@ -0,0 +1,58 @@
+//  MIT license
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "glad/glad.h"
+#include "gl_load.h"
+#include "quadtest.h"
+#include "pattern_atlas.h"
+#include "rt_pool.h"
+#include "compute_post.h"
+#include "present.h"
+#include "ref_raster.h"
+
+// Everything glsrgb renders, created per context: the dark-grey quad
+// (or the grid of every grey/alpha pair), directly or through an fbo
+// target that is post-processed to the default framebuffer.
+struct scene {
+    GLuint darkgrey_texture;
+    // its texels, and the grid's instances, for scene_reference
+    uint8_t darkgrey_pixels[4 * 4 * 4];
+    struct quadgrid_instance *grid_instances;
+    GLuint srgb_ramp;
+    // fbo targets, of fbo_format, multisampled with fbo_samples > 1
+    // (rendered to, then resolved into a single sample target)
+    struct rt_pool targets;
+    GLenum fbo_format;
+    int fbo_samples;
+    // invalidate each target before its clear and once it is consumed
+    int invalidate;
+    // GL: the default framebuffer is a linear one that must not encode,
+    // GL_FRAMEBUFFER_SRGB is off while the fbo is presented to it
+    int linear_window;
+    struct quadtest quad_darkgrey;
+    struct quadtest quad_postprocess;
+    // post-process with the compute program of this tile size, 0: quad
+    int compute_tile;
+    // how the fbo gets to the default framebuffer, if not by compute
+    struct present present;
+    enum present_strategy present_strategy;
+    struct compute_post compute;
+    // grid: every grey/alpha pair as a 256x256 grid instead of the quad
+    int grid;
+    struct pattern_atlas patterns;
+    struct quadgrid quad_grid;
+};
+
+// width x height: the first fbo target made (any size works later)
+int scene_setup(struct scene *scene, enum gl_api api, GLint gl_major, int width, int height, int grid);
+// the scene content, into the bound framebuffer
+void scene_draw(struct scene *scene);
+// one frame into the default framebuffer, through an fbo with use_fbo
+int scene_render(struct scene *scene, int use_fbo, int width, int height);
+// what scene_draw over a cleared direct frame should give, from the CPU
+// reference rasterizer sized width x height, as glReadPixels gives it
+int scene_reference(struct scene *scene, struct ref_raster *raster, uint8_t *out);
+void scene_teardown(struct scene *scene);
+
+#endif
@@ -0,0 +1,57 @@
+//  MIT license
+#include <math.h>
+#include <stddef.h>
+#include "srgb.h"
+
+float linear_to_srgb(float linear) {
+    // https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_sRGB.txt
+    double cl = linear;
+    if (isnan(cl)) return 0.0;
+    if (cl > 1.0) return 1.0;
+    if (cl <= 0.0) return 0.0;
+    if (cl < 0.0031308) return 12.92 * cl;
+    if (cl < 1) return 1.055 * pow(cl, 0.41666) - 0.055;
+    return 1;
+}
+
+float srgb_to_linear(float srgb) {
+    // see: https://en.wikipedia.org/wiki/SRGB
+    // https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_sRGB.txt
+    double cs = srgb;
+    if (cs < 0) cs = 0;
+    if (cs > 1) cs = 1;
+    if (cs <= 0.04045) return cs / 12.92;
+    return pow((cs + 0.055)/1.055, 2.4);
+}
+
+void srgb_grey_pma(uint8_t grey, uint8_t alpha, uint8_t out[4]) {
+    // premultiply in linear, encode once
+    float cl = srgb_to_linear(grey/255.0f) * (alpha/255.0f);
+    uint8_t cs = linear_to_srgb(cl)*255.0f + 0.5f;
+    out[0] = cs;
+    out[1] = cs;
+    out[2] = cs;
+    out[3] = alpha;
+}
+
+void srgb_grey_pma_pixels(uint8_t *pixels, int width, int height, uint8_t grey, uint8_t alpha) {
+    size_t rowbytes = width*4;
+    for (int py = 0; py < height; ++py) {
+        uint8_t *pixel = pixels + py * rowbytes;
+        for (int px = 0; px < width; ++px) {
+            srgb_grey_pma(grey, alpha, pixel);
+            pixel += 4;
+        }
+    }
+}
+
+void srgb_ramp(uint8_t *pixels, int range) {
+    // nearest lookup: texel i holds linear [i, i+1)/range, store the
+    // encode of its center, rounded, so that every sRGB value decoded
+    // and looked up comes back unchanged
+    for (int i = 0; i < range; ++i) {
+        float cl = (i+0.5)/(float)range;
+        float cs = linear_to_srgb(cl);
+        pixels[i] = cs*255.0 + 0.5;
+    }
+}
@@ -0,0 +1,20 @@
+//  MIT license
+#ifndef SRGB_H
+#define SRGB_H
+
+#include <stdint.h>
+
+// sRGB transfer functions as specified by EXT_sRGB, on [0,1] values
+float linear_to_srgb(float linear);
+float srgb_to_linear(float srgb);
+
+// RGBA8 texel of the grey test patches: grey with pre-multiplied alpha
+void srgb_grey_pma(uint8_t grey, uint8_t alpha, uint8_t out[4]);
+// width x height of those texels (rows are width*4 bytes)
+void srgb_grey_pma_pixels(uint8_t *pixels, int width, int height, uint8_t grey, uint8_t alpha);
+
+// linear -> sRGB lookup table of range entries, for a nearest lookup
+// with the linear value as the coordinate
+void srgb_ramp(uint8_t *pixels, int range);
+
+#endif
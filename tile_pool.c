@@ -0,0 +1,66 @@
+//  MIT license
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "tile_pool.h"
+
+struct pool {
+    void (*tile)(void *arg, int worker, int i);
+    void *arg;
+    int tiles;
+    atomic_int next_tile;
+};
+
+struct worker {
+    struct pool *pool;
+    int index;
+};
+
+int tile_pool_tiles(int height) {
+    return (height + TILE_POOL_ROWS - 1) / TILE_POOL_ROWS;
+}
+
+int tile_pool_threads(int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? cpus : 1;
+    }
+    return threads < TILE_POOL_MAX_THREADS ? threads : TILE_POOL_MAX_THREADS;
+}
+
+static void *work(void *arg) {
+    struct worker *worker = arg;
+    struct pool *pool = worker->pool;
+    for (;;) {
+        int i = atomic_fetch_add(&pool->next_tile, 1);
+        if (i >= pool->tiles) break;
+        pool->tile(pool->arg, worker->index, i);
+    }
+    return 0;
+}
+
+int tile_pool_run(int tiles, int threads, void (*tile)(void *arg, int worker, int i), void *arg) {
+    struct pool pool;
+    pool.tile = tile;
+    pool.arg = arg;
+    pool.tiles = tiles;
+    atomic_init(&pool.next_tile, 0);
+    threads = tile_pool_threads(threads);
+    if (threads > tiles) threads = tiles > 0 ? tiles : 1;
+    pthread_t thread_ids[TILE_POOL_MAX_THREADS];
+    struct worker workers[TILE_POOL_MAX_THREADS];
+    for (int i = 0; i < threads; ++i) {
+        workers[i].pool = &pool;
+        workers[i].index = i;
+    }
+    // this thread is one of the workers
+    int started = 0;
+    for (; started < threads - 1; ++started) {
+        if (pthread_create(&thread_ids[started], 0, work, &workers[started + 1])) break;
+    }
+    work(&workers[0]);
+    for (int i = 0; i < started; ++i) {
+        pthread_join(thread_ids[i], 0);
+    }
+    return started + 1;
+}
@@ -0,0 +1,21 @@
+//  MIT license
+#ifndef TILE_POOL_H
+#define TILE_POOL_H
+
+// Spreads the tiles of a frame (TILE_POOL_ROWS scanlines each) over
+// threads: every thread, the calling one included, takes the next tile
+// until none is left, so uneven tiles balance out. No pool is kept, the
+// threads only live for one tile_pool_run.
+#define TILE_POOL_ROWS 16
+#define TILE_POOL_MAX_THREADS 64
+
+// tiles of TILE_POOL_ROWS covering height scanlines
+int tile_pool_tiles(int height);
+// threads <= 0: one per online cpu; at most TILE_POOL_MAX_THREADS
+int tile_pool_threads(int threads);
+// calls tile(arg, worker, i) for each i in [0, tiles), worker is the
+// index of the calling thread, below the count returned (for per thread
+// state); fewer threads than asked run if some cannot be started
+int tile_pool_run(int tiles, int threads, void (*tile)(void *arg, int worker, int i), void *arg);
+
+#endif